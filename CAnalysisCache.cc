@@ -0,0 +1,198 @@
+#include <iostream>
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "CAnalysisCache.h"
+#include "CPackedBoard.h"
+#include "crc32.h"
+
+static const char MAGIC[8] = {'M', 'C', 'H', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t VERSION = 1;
+
+static_assert(sizeof(CMove) == 5, "CMove is stored in the cache file");
+
+/***************************************************************
+ * position
+ * The key and check value of the position.
+ ***************************************************************/
+void CAnalysisCache::position(const CBoard& board, uint64_t& key, uint32_t& check)
+{
+    key = board.getKey();
+
+    CPackedBoard packed;
+    board.pack(packed);
+    const uint8_t *p = (const uint8_t *) &packed;
+
+    CRC32 crc;
+    for (unsigned int i=0; i<offsetof(CPackedBoard, halfMoves); ++i)
+    {
+        crc.update(p[i]); // The move counters are not part of the position
+    }
+    check = crc.get();
+} // end of position
+
+#ifndef _WIN32
+
+/***************************************************************
+ * open
+ ***************************************************************/
+bool CAnalysisCache::open(const char *fileName, unsigned int sizeMb)
+{
+    close();
+
+    int fd = ::open(fileName, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = statbuf.st_size;
+    bool create = size == 0;
+    if (create)
+    {
+        // The number of entries is rounded down to a power of two.
+        uint64_t entries = ((uint64_t) sizeMb * 1024 * 1024) / sizeof(t_entry);
+        uint64_t count = 1;
+        while (2*count <= entries)
+            count *= 2;
+
+        size = sizeof(t_header) + count*sizeof(t_entry);
+        if (ftruncate(fd, size)) // The new file is all zeros, i.e. empty entries.
+        {
+            ::close(fd);
+            return false;
+        }
+    }
+
+    void *data = size >= sizeof(t_header) ?
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    t_header *header = (t_header *) data;
+    if (create)
+    {
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version = VERSION;
+        header->entrySize = sizeof(t_entry);
+        header->entries = (size - sizeof(t_header)) / sizeof(t_entry);
+    }
+
+    uint64_t entries = header->entries;
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION ||
+            header->entrySize != sizeof(t_entry) || entries == 0 || (entries & (entries-1)) ||
+            size != sizeof(t_header) + entries*sizeof(t_entry))
+    {
+        std::cerr << "Not an analysis cache: " << fileName << std::endl;
+        munmap(data, size);
+        return false;
+    }
+
+    // The entries are read at random.
+    madvise(data, size, MADV_RANDOM);
+
+    m_header  = header;
+    m_entries = (t_entry *) (header + 1);
+    m_mask    = entries - 1;
+    m_size    = size;
+    return true;
+} // end of open
+
+
+/***************************************************************
+ * close
+ ***************************************************************/
+void CAnalysisCache::close()
+{
+    if (m_header)
+        munmap(m_header, m_size);
+    m_header  = NULL;
+    m_entries = NULL;
+    m_mask    = 0;
+    m_size    = 0;
+} // end of close
+
+#else // _WIN32
+
+bool CAnalysisCache::open(const char *fileName, unsigned int)
+{
+    std::cerr << "The analysis cache is not supported on Windows: " << fileName << std::endl;
+    return false;
+}
+
+void CAnalysisCache::close()
+{
+}
+
+#endif // _WIN32
+
+
+/***************************************************************
+ * find
+ ***************************************************************/
+bool CAnalysisCache::find(const CBoard& board, int depth, t_result& result)
+{
+    if (!isOpen())
+        return false;
+
+    uint64_t key;
+    uint32_t check;
+    position(board, key, check);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const t_entry& entry = m_entries[key & m_mask];
+    if (entry.key != key || entry.check != check || entry.depth < depth)
+    {
+        m_misses++;
+        return false;
+    }
+
+    result.move  = entry.move;
+    result.score = entry.score;
+    result.depth = entry.depth;
+    result.nodes = entry.nodes;
+    m_hits++;
+    return true;
+} // end of find
+
+
+/***************************************************************
+ * insert
+ ***************************************************************/
+void CAnalysisCache::insert(const CBoard& board, const t_result& result)
+{
+    if (!isOpen() || !result.move.Valid() || result.depth <= 0)
+        return;
+
+    uint64_t key;
+    uint32_t check;
+    position(board, key, check);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    t_entry& entry = m_entries[key & m_mask];
+    if (entry.key == key && entry.check == check && entry.depth > result.depth)
+        return; // Keep the deeper result
+
+    entry.key      = key;
+    entry.check    = check;
+    entry.score    = result.score;
+    entry.depth    = std::min(result.depth, 255);
+    entry.reserved = 0;
+    entry.nodes    = result.nodes;
+    entry.move     = result.move;
+} // end of insert
+
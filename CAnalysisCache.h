@@ -0,0 +1,97 @@
+#ifndef _CANALYSISCACHE_H_
+#define _CANALYSISCACHE_H_
+
+#include <stdint.h>
+#include <mutex>
+
+#include "CBoard.h"
+#include "CMove.h"
+
+/***************************************************************
+ * declaration of CAnalysisCache
+ *
+ * This keeps the results of finished searches in a file, so the
+ * same position is not searched again, not even by the next run
+ * of the program. The file is memory-mapped for reading and
+ * writing, and the kernel writes the changes back.
+ *
+ * The cache is a table of 32 byte entries, indexed by the Zobrist
+ * key of the position (see CBoard::getKey). Each entry also holds a
+ * CRC32 of the packed position, so a different position with the
+ * same key is not taken for a hit. A new result replaces the old
+ * one in its entry, unless that is for the same position and was
+ * searched deeper.
+ *
+ * The file is in the byte order of the host. Its size is fixed,
+ * when it is created. May be used from several threads.
+ * Only supported on POSIX systems. On Windows open() fails.
+ ***************************************************************/
+class CAnalysisCache
+{
+    public:
+        struct t_result
+        {
+            t_result() : move(), score(0), depth(0), nodes(0) {}
+
+            CMove         move;
+            int           score;    // For the side to move, as AI::getScore()
+            int           depth;    // Plies, as AI::getDepth()
+            unsigned long nodes;
+        };
+
+        CAnalysisCache() : m_header(NULL), m_entries(NULL), m_mask(0), m_size(0),
+            m_mutex(), m_hits(0), m_misses(0) {}
+        ~CAnalysisCache() {close();}
+
+        // Maps the file, and creates it with sizeMb if it does not
+        // exist. Returns true on success.
+        bool open(const char *fileName, unsigned int sizeMb = 64);
+        void close();
+        bool isOpen() const {return m_entries != NULL;}
+
+        // Returns true, if a result for the position, searched to at
+        // least depth plies, is in the cache.
+        bool find(const CBoard& board, int depth, t_result& result);
+        void insert(const CBoard& board, const t_result& result);
+
+        unsigned long hits() const {return m_hits;}
+        unsigned long misses() const {return m_misses;}
+
+    private:
+        CAnalysisCache(const CAnalysisCache&) = delete;
+        CAnalysisCache& operator=(const CAnalysisCache&) = delete;
+
+        struct t_header
+        {
+            char     magic[8];
+            uint32_t version;
+            uint32_t entrySize;
+            uint64_t entries;
+            uint8_t  reserved[8];
+        };
+
+        struct t_entry
+        {
+            uint64_t key;       // Zobrist key, or 0 if empty
+            uint32_t check;     // CRC32 of the packed position
+            int16_t  score;
+            uint8_t  depth;
+            uint8_t  reserved;
+            uint64_t nodes;
+            CMove    move;
+        };
+
+        static void position(const CBoard& board, uint64_t& key, uint32_t& check);
+
+        t_header      *m_header;
+        t_entry       *m_entries;
+        uint64_t       m_mask;
+        size_t         m_size;      // Of the mapping, in bytes
+
+        std::mutex     m_mutex;
+        unsigned long  m_hits;
+        unsigned long  m_misses;
+}; // end of CAnalysisCache
+
+#endif // _CANALYSISCACHE_H_
+
@@ -0,0 +1,88 @@
+#include "CAsyncWriter.h"
+
+/***************************************************************
+ * open
+ ***************************************************************/
+bool CAsyncWriter::open(const char *fileName)
+{
+    close();
+
+    m_file = fopen(fileName, "wb");
+    if (m_file == NULL)
+        return false;
+
+    m_closing = false;
+    m_error = false;
+    m_bytes = 0;
+    m_thread = std::thread(&CAsyncWriter::run, this);
+    return true;
+} // end of open
+
+
+/***************************************************************
+ * write
+ ***************************************************************/
+void CAsyncWriter::write(std::vector<char>& block)
+{
+    if (block.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_queue.size() >= MAX_QUEUED)
+        m_cond.wait(lock);
+
+    m_queue.push_back(std::vector<char>());
+    m_queue.back().swap(block);
+    m_cond.notify_all();
+} // end of write
+
+
+/***************************************************************
+ * close
+ ***************************************************************/
+bool CAsyncWriter::close()
+{
+    if (m_file == NULL)
+        return !m_error;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closing = true;
+        m_cond.notify_all();
+    }
+    m_thread.join();
+
+    if (fclose(m_file))
+        m_error = true;
+    m_file = NULL;
+    return !m_error;
+} // end of close
+
+
+/***************************************************************
+ * run
+ * The background thread.
+ ***************************************************************/
+void CAsyncWriter::run()
+{
+    while (true)
+    {
+        std::vector<char> block;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_queue.empty() && !m_closing)
+                m_cond.wait(lock);
+            if (m_queue.empty())
+                return;
+            block.swap(m_queue.front());
+            m_queue.pop_front();
+            m_cond.notify_all();
+        }
+
+        // The file is only touched by this thread.
+        if (fwrite(&block[0], 1, block.size(), m_file) != block.size())
+            m_error = true;
+        m_bytes += block.size();
+    }
+} // end of run
+
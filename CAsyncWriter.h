@@ -0,0 +1,57 @@
+#ifndef _CASYNCWRITER_H_
+#define _CASYNCWRITER_H_
+
+#include <stdio.h>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/***************************************************************
+ * declaration of CAsyncWriter
+ *
+ * This writes blocks of bytes to a file on a background thread,
+ * so the threads producing the data don't wait for the disk.
+ * Blocks are written in the order they are queued. If the disk
+ * falls behind by more than MAX_QUEUED blocks, write() waits.
+ ***************************************************************/
+class CAsyncWriter
+{
+    public:
+        CAsyncWriter() : m_file(NULL), m_thread(), m_mutex(), m_cond(),
+            m_queue(), m_closing(false), m_error(false), m_bytes(0) {}
+        ~CAsyncWriter() {close();}
+
+        bool open(const char *fileName);
+
+        // Queues the block. The block is left empty.
+        void write(std::vector<char>& block);
+
+        // Writes all queued blocks, and closes the file.
+        // Returns false, if any write failed.
+        bool close();
+
+        unsigned long long bytes() const {return m_bytes;}
+
+    private:
+        CAsyncWriter(const CAsyncWriter&) = delete;
+        CAsyncWriter& operator=(const CAsyncWriter&) = delete;
+
+        enum {MAX_QUEUED = 64};
+
+        void run();
+
+        FILE                             *m_file;
+        std::thread                       m_thread;
+        std::mutex                        m_mutex;
+        std::condition_variable           m_cond;
+        std::deque<std::vector<char> >    m_queue;
+        bool                              m_closing;
+        bool                              m_error;
+        std::atomic<unsigned long long>   m_bytes;   // Written so far
+}; // end of CAsyncWriter
+
+#endif // _CASYNCWRITER_H_
+
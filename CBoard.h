@@ -3,6 +3,7 @@
 
 #include "CMove.h"
 #include "CMoveList.h"
+#include "CPackedBoard.h"
 
 #ifndef _C_BOARD_H_
 #define _C_BOARD_H_
@@ -57,7 +58,7 @@ class CBoard
     public:
         CBoard() : m_board(), m_state(), m_side_to_move(), m_castleRights(),
             m_enPassantSquare(), m_material(), m_halfMoves(), m_fullMoves(), 
-            number_of_pieces(32), last_capture_or_pawn_move()
+            number_of_pieces(32), m_key()
             { newGame(); }
 
         // Copy constructor
@@ -70,25 +71,48 @@ class CBoard
         void make_move(const CMove &move);
         void undo_move(const CMove &move);
         int  getValue();
+        int  getPieces(int *pieces, int *squares) const;
+
+        // Conversions of a piece and a square to the NNUE representation (see nnue.h)
+        static int nnuePiece(int piece) {return piece > 0 ? 7 - piece : 13 + piece;}
+        static int nnueSquare(int sq) {return (sq/10 - 2)*8 + (sq%10) - 1;}
+        void pack(CPackedBoard& packed) const;
+        bool unpack(const CPackedBoard& packed);
+        std::string toFen() const;
         bool IsMoveValid(CMove &move) const;
+        bool isMoveLegal(CMove &move);
 #ifdef DEBUG_HASH
         uint32_t calcHash() const;
 #endif
         bool isKingInCheck() const;
         bool isOtherKingInCheck() const;
         bool whiteToMove() const {return m_side_to_move > 0;}
-        bool fiftyMoveDraw() const { return last_capture_or_pawn_move >= 50; }
+        int  getMaterial() const {return m_material;} // In pawns, for the side to move
+        bool fiftyMoveDraw() const { return m_halfMoves >= 100; }
+        bool isInsufficientMaterial() const;
+        bool hasLegalMove();
+
+        // The Zobrist key of the position. It is updated by make_move,
+        // and restored by undo_move.
+        uint64_t getKey() const {return m_key;}
+        uint64_t keyAfter(const CMove& move) const;
 
         friend std::ostream& operator <<(std::ostream &os, const CBoard &rhs);
-        friend class CHashEntry;
 
     private:
         void calcMaterial();
+        void calcKey();
         bool isSquareThreatened(const CSquare& sq) const;
         void swap_sides() {m_side_to_move = -m_side_to_move;}
 
+        struct t_state
+        {
+            uint32_t flags; // m_halfMoves, m_enPassantSquare and m_castleRights
+            uint64_t key;
+        };
+
         std::vector<int8_t>   m_board;
-        std::vector<uint32_t> m_state; // Contains a log of m_enPassantSquare and m_castleRights
+        std::vector<t_state>  m_state; // Contains a log of the state before each move
         int m_side_to_move;
         int m_castleRights;
 #define CASTLE_WHITE_SHORT (1<<0)
@@ -101,7 +125,7 @@ class CBoard
         int m_fullMoves;
 
         int number_of_pieces;
-        int last_capture_or_pawn_move;
+        uint64_t m_key;
 
 }; // end of class CBoard
 
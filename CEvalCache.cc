@@ -0,0 +1,65 @@
+#include "CEvalCache.h"
+
+#define KEY_MASK   (~(uint64_t) 0xFFFF)
+#define VALUE_MASK ((uint64_t) 0xFFFF)
+
+/***************************************************************
+ * constructor
+ * The number of slots is rounded down to a power of two.
+ ***************************************************************/
+CEvalCache::CEvalCache(unsigned int sizeMb)
+    : m_table(), m_mask(), m_hits(0), m_misses(0)
+{
+    uint64_t slots = ((uint64_t) sizeMb * 1024 * 1024) / sizeof(uint64_t);
+    uint64_t size = 1;
+    while (2*size <= slots)
+        size *= 2;
+
+    std::vector<std::atomic<uint64_t> > table(size);
+    m_table.swap(table);
+    m_mask = size - 1;
+    clear();
+} // end of constructor
+
+
+/***************************************************************
+ * clear
+ ***************************************************************/
+void CEvalCache::clear()
+{
+    for (unsigned int i=0; i<m_table.size(); ++i)
+    {
+        m_table[i].store(0, std::memory_order_relaxed);
+    }
+    m_hits.store(0, std::memory_order_relaxed);
+    m_misses.store(0, std::memory_order_relaxed);
+} // end of clear
+
+
+/***************************************************************
+ * find
+ * Returns true if the value of this position is stored.
+ ***************************************************************/
+bool CEvalCache::find(uint64_t hashValue, int& value)
+{
+    uint64_t slot = m_table[hashValue & m_mask].load(std::memory_order_relaxed);
+    if (slot != 0 && ((slot ^ hashValue) & KEY_MASK) == 0)
+    {
+        value = (int16_t) (slot & VALUE_MASK);
+        m_hits.store(m_hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+    m_misses.store(m_misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+} // end of find
+
+
+/***************************************************************
+ * insert
+ ***************************************************************/
+void CEvalCache::insert(uint64_t hashValue, int value)
+{
+    uint64_t slot = (hashValue & KEY_MASK) | ((uint16_t) value & VALUE_MASK);
+    m_table[hashValue & m_mask].store(slot, std::memory_order_relaxed); // Overwrite any existing value
+} // end of insert
+
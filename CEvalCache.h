@@ -0,0 +1,52 @@
+#ifndef _CEVALCACHE_H_
+#define _CEVALCACHE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+/***************************************************************
+ * declaration of CEvalCache
+ *
+ * This is a small cache of static (NNUE) evaluations, indexed by
+ * the 64-bit hash value of the position (see CHashEntry).
+ *
+ * Each slot is a single 64-bit word. The upper 48 bits hold the
+ * upper bits of the hash value, and the lower 16 bits hold the
+ * value for the side to move. Since a slot is read and written
+ * in one go, the cache needs no locking and may be shared between
+ * threads. It is lossy: A new entry always overwrites the old one.
+ ***************************************************************/
+class CEvalCache
+{
+    public:
+        CEvalCache(unsigned int sizeMb = 8);
+
+        bool find(uint64_t hashValue, int& value);
+        void insert(uint64_t hashValue, int value);
+        void clear();
+
+        // Starts loading the slot of hashValue into the cache.
+        void prefetch(uint64_t hashValue) const
+        {
+#ifdef __GNUC__
+            __builtin_prefetch(&m_table[hashValue & m_mask]);
+#else
+            (void) hashValue;
+#endif
+        }
+
+        unsigned long hits()   const {return m_hits.load(std::memory_order_relaxed);}
+        unsigned long misses() const {return m_misses.load(std::memory_order_relaxed);}
+
+    private:
+        std::vector<std::atomic<uint64_t> > m_table;
+        uint64_t      m_mask;
+
+        // The statistics are only approximate, when the cache is shared.
+        std::atomic<unsigned long> m_hits;
+        std::atomic<unsigned long> m_misses;
+}; // end of CEvalCache
+
+#endif // _CEVALCACHE_H_
+
@@ -2,7 +2,6 @@
 #define _CHASHENTRY_H_
 
 #include "CMove.h"
-#include "CBoard.h"
 
 // For performance reasons, this bit structure must fit into 1 byte.
 typedef struct
@@ -29,8 +28,6 @@ class CHashEntry
 
         CHashEntry() : m_hashValue(), m_bestMove(), m_nodeTypeAndLevel(), m_searchValue()
             {}
-        void set(const CBoard& board);
-        void update(const CBoard& board, const CMove& move);
         std::string ToString() const;
 
         operator uint64_t() const {return m_hashValue; }
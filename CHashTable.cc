@@ -1,23 +1,62 @@
+#include <algorithm>
+#include <vector>
+#include <new>
+#include <fstream>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "CHashTable.h"
+#include "misc.h"
 
-#define TABLE_SIZE (8*1024*1024)
+static const char MAGIC[8] = {'M', 'C', 'H', 'H', 'A', 'S', 'H', 0};
+static const uint32_t VERSION = 1;
 
 /***************************************************************
  * constructor
+ * The number of entries is rounded down to a power of two.
  ***************************************************************/
-CHashTable::CHashTable()
-    : m_table()
+CHashTable::CHashTable(unsigned int sizeMb)
+    : m_table(NULL), m_mask(), m_memory(NULL), m_memorySize(0), m_pageMode(""),
+    m_map(NULL), m_mapSize(0)
 {
-    m_table.reserve(TABLE_SIZE);
+    uint64_t entries = ((uint64_t) sizeMb * 1024 * 1024) / sizeof(CHashEntry);
+    uint64_t size = 1;
+    while (2*size <= entries)
+        size *= 2;
+
+    m_memorySize = size * sizeof(CHashEntry);
+    m_memory = (CHashEntry *) alloc_large(m_memorySize, &m_pageMode);
+    if (m_memory == NULL)
+        throw std::bad_alloc();
+
+    m_table = m_memory;
+    m_mask = size - 1;
+    clear();
 }
 
 
+/***************************************************************
+ * destructor
+ ***************************************************************/
+CHashTable::~CHashTable()
+{
+    unmap();
+    free_large(m_memory, m_memorySize);
+} // end of destructor
+
+
 /***************************************************************
  * insert
  ***************************************************************/
 void CHashTable::insert(const CHashEntry& hashEntry)
 {
-    uint32_t ix = hashEntry.m_hashValue & (TABLE_SIZE - 1);
+    uint32_t ix = hashEntry.m_hashValue & m_mask;
     m_table[ix] = hashEntry; // Overwrite any existing value
 } // end of insert
 
@@ -27,7 +66,7 @@ void CHashTable::insert(const CHashEntry& hashEntry)
  ***************************************************************/
 bool CHashTable::find(uint64_t hashValue, CHashEntry& hashEntry) const
 {
-    uint32_t ix = hashValue & (TABLE_SIZE - 1);
+    uint32_t ix = hashValue & m_mask;
     if (m_table[ix].m_hashValue == hashValue)
     {
         hashEntry = m_table[ix];
@@ -36,3 +75,196 @@ bool CHashTable::find(uint64_t hashValue, CHashEntry& hashEntry) const
     return false;
 } // end of find
 
+
+/***************************************************************
+ * hashfull
+ * Returns how full the table is, in permille, as in the UCI
+ * "info hashfull". Only the first 1000 entries are counted.
+ ***************************************************************/
+unsigned int CHashTable::hashfull() const
+{
+    unsigned int samples = std::min<uint64_t>(1000, m_mask + 1);
+    unsigned int used = 0;
+    for (unsigned int i=0; i<samples; ++i)
+    {
+        if (m_table[i].m_hashValue != 0)
+            used++;
+    }
+    return samples ? used*1000/samples : 0;
+} // end of hashfull
+
+
+/***************************************************************
+ * clear
+ ***************************************************************/
+void CHashTable::clear()
+{
+    std::fill(m_table, m_table + m_mask + 1, CHashEntry());
+} // end of clear
+
+
+/***************************************************************
+ * validHeader
+ ***************************************************************/
+bool CHashTable::validHeader(const t_header& header)
+{
+    return memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+        header.version == VERSION && header.entrySize == sizeof(CHashEntry) &&
+        header.entries > 0 && (header.entries & (header.entries-1)) == 0;
+} // end of validHeader
+
+
+/***************************************************************
+ * save
+ ***************************************************************/
+bool CHashTable::save(const char *fileName) const
+{
+    std::ofstream file(fileName, std::ios::binary);
+
+    t_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entrySize = sizeof(CHashEntry);
+    header.entries = m_mask + 1;
+
+    file.write((const char *) &header, sizeof(header));
+    file.write((const char *) m_table, (m_mask + 1) * sizeof(CHashEntry));
+    file.close();
+    return !file.fail();
+} // end of save
+
+
+/***************************************************************
+ * load
+ ***************************************************************/
+bool CHashTable::load(const char *fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+
+    t_header header;
+    if (!file.read((char *) &header, sizeof(header)) || !validHeader(header))
+        return false;
+
+    if (header.entries == m_mask + 1)
+    {
+        if (file.read((char *) m_table, header.entries * sizeof(CHashEntry)))
+            return true;
+        clear(); // Not a half loaded table
+        return false;
+    }
+
+    // Another size. Entries that end up in the same place overwrite each other.
+    clear();
+    std::vector<CHashEntry> chunk(4096);
+    for (uint64_t left = header.entries; left > 0; )
+    {
+        uint64_t count = std::min<uint64_t>(left, chunk.size());
+        if (!file.read((char *) &chunk[0], count * sizeof(CHashEntry)))
+        {
+            clear();
+            return false;
+        }
+        for (uint64_t i=0; i<count; ++i)
+        {
+            if (chunk[i].m_hashValue != 0)
+                insert(chunk[i]);
+        }
+        left -= count;
+    }
+    return true;
+} // end of load
+
+#ifndef _WIN32
+
+/***************************************************************
+ * mapFile
+ ***************************************************************/
+bool CHashTable::mapFile(const char *fileName)
+{
+    int fd = open(fileName, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = statbuf.st_size;
+    bool create = size == 0;
+    if (create)
+    {
+        size = sizeof(t_header) + (m_mask + 1) * sizeof(CHashEntry);
+        if (ftruncate(fd, size))
+        {
+            close(fd);
+            return false;
+        }
+    }
+
+    void *data = size >= sizeof(t_header) ?
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    t_header *header = (t_header *) data;
+    CHashEntry *table = (CHashEntry *) (header + 1);
+    if (create)
+    {
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version = VERSION;
+        header->entrySize = sizeof(CHashEntry);
+        header->entries = m_mask + 1;
+        std::copy(m_table, m_table + m_mask + 1, table);
+    }
+
+    if (!validHeader(*header) || size != sizeof(t_header) + header->entries * sizeof(CHashEntry))
+    {
+        munmap(data, size);
+        return false;
+    }
+
+    // The search reads the table at random.
+    madvise(data, size, MADV_RANDOM);
+
+    unmap();
+    free_large(m_memory, m_memorySize);
+    m_memory = NULL;
+    m_memorySize = 0;
+    m_pageMode = "a mapped file";
+    m_map = data;
+    m_mapSize = size;
+    m_table = table;
+    m_mask = header->entries - 1;
+    return true;
+} // end of mapFile
+
+
+/***************************************************************
+ * unmap
+ ***************************************************************/
+void CHashTable::unmap()
+{
+    if (m_map)
+        munmap(m_map, m_mapSize);
+    m_map = NULL;
+    m_mapSize = 0;
+} // end of unmap
+
+#else // _WIN32
+
+bool CHashTable::mapFile(const char *)
+{
+    return false;
+}
+
+void CHashTable::unmap()
+{
+}
+
+#endif // _WIN32
+
@@ -1,26 +1,85 @@
 #ifndef _CHASHTABLE_H_
 #define _CHASHTABLE_H_
 
-#include <vector>
-
 #include "CBoard.h"
 #include "CHashEntry.h"
 
 /***************************************************************
  * declaration of CHashTable
  *
- * This is a wrapper for the std::vector class.
- * It contains an array of hash values.
+ * This is an array of hash values, either in memory, or in a
+ * file that is mapped into memory (see mapFile). The memory is
+ * on huge pages if possible (see alloc_large), as the table is
+ * much larger than what the TLB covers with normal pages.
+ *
+ * The table can be saved to a file, and loaded again, e.g. to go
+ * on with an analysis after a restart. The file is a header and
+ * the entries as they are in memory, so it is in the byte order
+ * of the host.
  ***************************************************************/
 class CHashTable
 {
     public:
-        CHashTable();
+        CHashTable(unsigned int sizeMb = 128);
+        ~CHashTable();
         void insert(const CHashEntry& hashEntry);
         bool find(uint64_t hashValue, CHashEntry& hashEntry) const;
-        
+        unsigned int hashfull() const;
+
+        // Starts loading the entry of hashValue into the cache, so a
+        // find() soon after does not wait for memory.
+        void prefetch(uint64_t hashValue) const
+        {
+#ifdef __GNUC__
+            __builtin_prefetch(&m_table[hashValue & m_mask]);
+#else
+            (void) hashValue;
+#endif
+        }
+        void clear();
+
+        // The kind of pages the table is on, e.g. "huge pages (madvise)".
+        const char *pageMode() const {return m_pageMode;}
+
+        // Writes the table to the file. Returns true on success.
+        bool save(const char *fileName) const;
+
+        // Reads a table written by save() or mapFile(). If it has
+        // another size, the entries are inserted one by one.
+        // Returns true on success. If the file is not a table, the
+        // table is unchanged. If it is cut short, the table is cleared.
+        bool load(const char *fileName);
+
+        // From now on the table is kept in the file, so it is saved
+        // without copying, also when the program ends. A new file
+        // gets the size and contents of the table. An existing file
+        // keeps its size and contents, and the table is replaced by
+        // it. Returns true on success. Not supported on Windows.
+        bool mapFile(const char *fileName);
+
     private:
-        std::vector<CHashEntry> m_table;
+        CHashTable(const CHashTable&) = delete;
+        CHashTable& operator=(const CHashTable&) = delete;
+
+        struct t_header
+        {
+            char     magic[8];
+            uint32_t version;
+            uint32_t entrySize;
+            uint64_t entries;
+            uint8_t  reserved[8];
+        };
+
+        void unmap();
+        static bool validHeader(const t_header& header);
+
+        CHashEntry             *m_table;
+        uint64_t                m_mask;
+        CHashEntry             *m_memory;   // The table, unless it is mapped
+        size_t                  m_memorySize;
+        const char             *m_pageMode;
+        void                   *m_map;      // The mapped file, or NULL
+        size_t                  m_mapSize;
 }; // end of CHashTable
 
 #endif // _CHASHTABLE_H_
@@ -0,0 +1,82 @@
+#include "CLineFile.h"
+
+/***************************************************************
+ * open
+ ***************************************************************/
+bool CLineFile::open(const char *fileName, bool sequential)
+{
+    close();
+
+    FD fd = open_file(fileName);
+    if (fd == FD_ERR)
+        return false;
+    m_size = file_size(fd);
+    if (m_size)
+        m_data = (const char *) map_file(fd, &m_map);
+    close_file(fd);
+
+    if (m_data == NULL)
+    {
+        bool empty = m_size == 0;
+        m_size = 0;
+        return empty;
+    }
+
+#if !defined(_WIN32) && defined(MADV_SEQUENTIAL)
+    // map_file asks for random access, which disables read-ahead.
+    if (sequential)
+        madvise((void *) m_data, m_size, MADV_SEQUENTIAL);
+#else
+    (void) sequential;
+#endif
+
+    return true;
+} // end of open
+
+
+/***************************************************************
+ * close
+ ***************************************************************/
+void CLineFile::close()
+{
+    unmap_file(m_data, m_map);
+    m_data = NULL;
+    m_size = 0;
+} // end of close
+
+
+/***************************************************************
+ * head
+ ***************************************************************/
+CLineFile::t_range CLineFile::head(const t_range& range, size_t bytes)
+{
+    t_range result = range;
+    if (bytes < (size_t) (range.end - range.begin))
+    {
+        const char *p = range.begin + bytes;
+        const char *eol = (const char *) memchr(p, '\n', range.end - p);
+        if (eol)
+            result.end = eol + 1;
+    }
+    return result;
+} // end of head
+
+
+/***************************************************************
+ * split
+ ***************************************************************/
+std::vector<CLineFile::t_range> CLineFile::split(const t_range& range, unsigned int parts)
+{
+    std::vector<t_range> ranges;
+    if (parts == 0)
+        parts = 1;
+
+    size_t bytes = (range.end - range.begin + parts - 1) / parts;
+    t_range rest = range;
+    while (rest.begin < rest.end)
+    {
+        ranges.push_back(head(rest, bytes ? bytes - 1 : 0));
+        rest.begin = ranges.back().end;
+    }
+    return ranges;
+} // end of split
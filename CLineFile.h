@@ -0,0 +1,81 @@
+#ifndef _CLINEFILE_H_
+#define _CLINEFILE_H_
+
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <algorithm> // Before misc.h, which defines a clamp macro
+
+#include "misc.h"
+
+/***************************************************************
+ * declaration of CLineFile
+ *
+ * This is a text file, memory-mapped for reading. The lines are
+ * not copied: a range of the file is a pair of pointers into the
+ * mapping, and workers can each take a range, and walk the lines
+ * in it with forEachLine(). Ranges always end after a line end
+ * (or at the end of the file), so no line is split.
+ *
+ * The mapping is not zero terminated.
+ ***************************************************************/
+class CLineFile
+{
+    public:
+        struct t_range
+        {
+            const char *begin;
+            const char *end;
+        };
+
+        CLineFile() : m_data(NULL), m_size(0), m_map() {}
+        ~CLineFile() {close();}
+
+        // Maps the file. With sequential, the kernel is told to read
+        // ahead, otherwise that the file is read at random.
+        // Returns true on success. An empty file is not an error.
+        bool open(const char *fileName, bool sequential = true);
+        void close();
+
+        const char *begin() const {return m_data;}
+        const char *end() const {return m_data + m_size;}
+        size_t size() const {return m_size;}
+        t_range all() const {t_range range = {begin(), end()}; return range;}
+
+        // The first lines of the range, at least bytes long, or all of it.
+        static t_range head(const t_range& range, size_t bytes);
+
+        // The range cut into at most parts ranges of about the same size.
+        static std::vector<t_range> split(const t_range& range, unsigned int parts);
+
+        // Calls fn(line, length) for every line in the range. Trailing
+        // white space, including the line end, is not part of the line.
+        template<class Fn>
+        static void forEachLine(const t_range& range, Fn fn)
+        {
+            const char *p = range.begin;
+            while (p < range.end)
+            {
+                const char *eol = (const char *) memchr(p, '\n', range.end - p);
+                if (eol == NULL)
+                    eol = range.end;
+
+                size_t length = eol - p;
+                while (length && isspace((unsigned char) p[length-1]))
+                    length--;
+                fn(p, length);
+
+                p = eol + 1;
+            }
+        }
+
+    private:
+        CLineFile(const CLineFile&) = delete;
+        CLineFile& operator=(const CLineFile&) = delete;
+
+        const char *m_data;
+        size_t      m_size;
+        map_t       m_map;
+}; // end of CLineFile
+
+#endif // _CLINEFILE_H_
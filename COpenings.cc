@@ -0,0 +1,73 @@
+#include <ctype.h>
+#include <sstream>
+
+#include "COpenings.h"
+
+/***************************************************************
+ * load
+ * Maps the file, and finds the lines with a position.
+ * Empty lines and comments are skipped. Returns true on success.
+ ***************************************************************/
+bool COpenings::load(const char *fileName)
+{
+    unload();
+
+    // The suite is read once here, and then at random.
+    if (!m_file.open(fileName, false))
+        return false;
+
+    CLineFile::forEachLine(m_file.all(), [this](const char *line, size_t length)
+    {
+        if (length && line[0] != '#')
+            m_lines.push_back(t_line {line, length});
+    });
+
+    return !m_lines.empty();
+} // end of load
+
+
+/***************************************************************
+ * unload
+ ***************************************************************/
+void COpenings::unload()
+{
+    m_file.close();
+    m_lines.clear();
+} // end of unload
+
+
+/***************************************************************
+ * fen
+ * The first four fields are always part of the FEN. The move
+ * counters are optional, and anything else is an EPD operation.
+ ***************************************************************/
+std::string COpenings::fen(unsigned int index) const
+{
+    if (index >= m_lines.size())
+        return "";
+
+    // The mapped file is not zero terminated.
+    const t_line& line = m_lines[index];
+    std::istringstream is(std::string(line.begin, line.length));
+
+    std::string fen, field;
+    for (int i = 0; i < 6 && is >> field; ++i)
+    {
+        if (i >= 4 && !isdigit((unsigned char) field[0]))
+            break;
+        fen += (i ? " " : "") + field;
+    }
+    return fen;
+} // end of fen
+
+
+/***************************************************************
+ * setup
+ ***************************************************************/
+bool COpenings::setup(CBoard& board, unsigned int index) const
+{
+    if (index >= m_lines.size())
+        return true;
+
+    return board.read_from_fen(fen(index).c_str());
+} // end of setup
@@ -0,0 +1,50 @@
+#ifndef _COPENINGS_H_
+#define _COPENINGS_H_
+
+#include <string>
+#include <vector>
+
+#include "CBoard.h"
+#include "CLineFile.h"
+
+/***************************************************************
+ * declaration of COpenings
+ *
+ * This is a suite of start positions, one FEN or EPD per line.
+ * The file is memory-mapped (see CLineFile), and only the lines
+ * are kept, so a large suite costs little memory. After load()
+ * the suite is read-only, and may be shared by all workers.
+ ***************************************************************/
+class COpenings
+{
+    public:
+        COpenings() : m_file(), m_lines() {}
+        ~COpenings() {unload();}
+
+        bool load(const char *fileName);
+        void unload();
+
+        unsigned int size() const {return m_lines.size();}
+
+        // The FEN of the opening, without any EPD operations.
+        std::string fen(unsigned int index) const;
+
+        // Sets up the board with the opening. Returns true on error.
+        bool setup(CBoard& board, unsigned int index) const;
+
+    private:
+        COpenings(const COpenings&) = delete;
+        COpenings& operator=(const COpenings&) = delete;
+
+        struct t_line
+        {
+            const char *begin;
+            size_t      length;
+        };
+
+        CLineFile              m_file;
+        std::vector<t_line>    m_lines;
+}; // end of COpenings
+
+#endif // _COPENINGS_H_
+
@@ -0,0 +1,34 @@
+#ifndef _CPACKEDBOARD_H_
+#define _CPACKEDBOARD_H_
+
+#include <stdint.h>
+
+/***************************************************************
+ * declaration of CPackedBoard
+ *
+ * This is a position in a fixed size of 32 bytes, for storing
+ * large numbers of positions, e.g. training data.
+ *
+ * The occupied squares are a bitboard (square a1 is bit 0, h8 is
+ * bit 63). Then follows one nibble for each occupied square, in
+ * square order, low nibble first: 1-6 is a white pawn, knight,
+ * bishop, rook, queen and king, and 9-14 is the same in black.
+ *
+ * The multi-byte fields are stored in the byte order of the host.
+ ***************************************************************/
+struct CPackedBoard
+{
+    uint64_t occupied;
+    uint8_t  pieces[16];
+    uint8_t  state;       // Bit 0: black to move. Bits 1-4: castling rights
+    uint8_t  enPassant;   // En passant square (a1=0), or 0 if none
+    uint8_t  halfMoves;   // For the 50-move rule, at most 255
+    uint8_t  reserved;
+    uint16_t fullMoves;
+    uint16_t reserved2;
+};
+
+static_assert(sizeof(CPackedBoard) == 32, "CPackedBoard must be 32 bytes");
+
+#endif // _CPACKEDBOARD_H_
+
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <stdlib.h>
+
+#include "CReferee.h"
+
+/***************************************************************
+ * constructor
+ ***************************************************************/
+CReferee::CReferee(const t_adjudication& adj, const CSearchLimits& limits)
+    : m_adj(adj), m_limits(limits), m_clocks(limits.wtime > 0 || limits.btime > 0),
+    m_clock(), m_moveStart(), m_history(), m_ply(0),
+    m_resignCount(0), m_resignSide(0), m_drawCount(0), m_winner(0), m_reason("")
+{
+} // end of constructor
+
+
+/***************************************************************
+ * newGame
+ * Starts a new game from the position on the board.
+ ***************************************************************/
+void CReferee::newGame(const CBoard& board)
+{
+    m_clock[0] = m_limits.wtime;
+    m_clock[1] = m_limits.btime;
+
+    m_history.clear();
+    m_history.push_back(board.getKey());
+
+    m_ply = 0;
+    m_resignCount = 0;
+    m_resignSide = 0;
+    m_drawCount = 0;
+    m_winner = 0;
+    m_reason = "";
+} // end of newGame
+
+
+/***************************************************************
+ * limits
+ * The search limits for the next move, with the clocks.
+ ***************************************************************/
+CSearchLimits CReferee::limits() const
+{
+    CSearchLimits limits = m_limits;
+    if (m_clocks)
+    {
+        limits.wtime = std::max(1, m_clock[0]);
+        limits.btime = std::max(1, m_clock[1]);
+    }
+    return limits;
+} // end of limits
+
+
+/***************************************************************
+ * beforeMove
+ * Checks for mate and stalemate.
+ ***************************************************************/
+bool CReferee::beforeMove(CBoard& board)
+{
+    if (board.hasLegalMove())
+        return false;
+
+    if (board.isKingInCheck())
+        return end(board.whiteToMove() ? -1 : 1, "checkmate");
+
+    return end(0, "stalemate");
+} // end of beforeMove
+
+
+/***************************************************************
+ * forfeit
+ ***************************************************************/
+void CReferee::forfeit(const CBoard& board, const char *reason)
+{
+    end(board.whiteToMove() ? -1 : 1, reason);
+} // end of forfeit
+
+
+/***************************************************************
+ * afterMove
+ * The move has been made on the board, and value is the NNUE
+ * value of the new position, for the side to move.
+ ***************************************************************/
+bool CReferee::afterMove(CBoard& board, const CMove& move, int value)
+{
+    m_ply++;
+
+    // The side that made the move
+    int mover = board.whiteToMove() ? -1 : 1;
+
+    if (m_clocks)
+    {
+        int& clock = m_clock[mover > 0 ? 0 : 1];
+        clock -= CTimeDiff(m_moveStart).millisecs();
+        if (clock < 0)
+            return end(-mover, "time forfeit");
+        clock += mover > 0 ? m_limits.winc : m_limits.binc;
+    }
+
+    // A move into check is only chosen, when all moves lose.
+    if (board.isOtherKingInCheck())
+        return end(-mover, "illegal move");
+
+    if (board.fiftyMoveDraw())
+    {
+        // Mate has priority over the 50-move rule.
+        if (!board.hasLegalMove())
+            return beforeMove(board);
+        return end(0, "50-move rule");
+    }
+
+    if (board.isInsufficientMaterial())
+        return end(0, "insufficient material");
+
+    if (move.is_it_a_capture() || move.GetPiece() == WP || move.GetPiece() == BP)
+        m_history.clear();
+    m_history.push_back(board.getKey());
+    if (std::count(m_history.begin(), m_history.end(), m_history.back()) >= 3)
+        return end(0, "threefold repetition");
+
+    // Adjudication on the score, seen from white.
+    int score = board.whiteToMove() ? value : -value;
+
+    if (m_adj.resignPlies > 0 && m_adj.resignScore > 0 && abs(score) >= m_adj.resignScore)
+    {
+        int side = score > 0 ? 1 : -1;
+        m_resignCount = side == m_resignSide ? m_resignCount + 1 : 1;
+        m_resignSide = side;
+    }
+    else
+    {
+        m_resignCount = 0;
+    }
+    if (m_adj.resignPlies > 0 && m_resignCount >= m_adj.resignPlies)
+        return end(m_resignSide, "adjudicated win");
+
+    if (m_adj.drawPlies > 0 && m_ply >= m_adj.drawMinPly && abs(score) <= m_adj.drawScore)
+        m_drawCount++;
+    else
+        m_drawCount = 0;
+    if (m_adj.drawPlies > 0 && m_drawCount >= m_adj.drawPlies)
+        return end(0, "adjudicated draw");
+
+    if (m_adj.maxPlies > 0 && m_ply >= m_adj.maxPlies)
+        return end(0, "maximum length");
+
+    return false;
+} // end of afterMove
+
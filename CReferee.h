@@ -0,0 +1,80 @@
+#ifndef _CREFEREE_H_
+#define _CREFEREE_H_
+
+#include <vector>
+#include <stdint.h>
+
+#include "CBoard.h"
+#include "CMove.h"
+#include "CSearchLimits.h"
+#include "CTime.h"
+
+// Adjudication of games, whose result is clear before the end.
+// The scores are NNUE values. A value of zero disables the rule.
+struct t_adjudication
+{
+    t_adjudication() : resignScore(0), resignPlies(0),
+        drawScore(0), drawPlies(0), drawMinPly(0), maxPlies(0) {}
+
+    int resignScore; // A side loses, when its score is -resignScore or worse
+    int resignPlies; //  for this many consecutive plies.
+    int drawScore;   // The game is drawn, when the score is within +/- drawScore
+    int drawPlies;   //  for this many consecutive plies,
+    int drawMinPly;  //  but not before this ply.
+    int maxPlies;    // The game is drawn after this many plies.
+};
+
+
+/***************************************************************
+ * declaration of CReferee
+ *
+ * This decides when a game is over: By the rules (mate, stalemate,
+ * 50 moves, threefold repetition, insufficient material), by the
+ * clock, or by adjudication. The clocks run only when the limits
+ * have wtime or btime; both sides start with the same time.
+ *
+ * For each move, call beforeMove(), limits() and startClock()
+ * before searching, and afterMove() once the move is made.
+ ***************************************************************/
+class CReferee
+{
+    public:
+        CReferee(const t_adjudication& adj, const CSearchLimits& limits);
+        CReferee(const CReferee&) = default;
+        CReferee& operator=(const CReferee&) = default;
+
+        void newGame(const CBoard& board);
+
+        // Returns true, if the game is over.
+        bool beforeMove(CBoard& board);
+        bool afterMove(CBoard& board, const CMove& move, int value);
+
+        // The side to move loses, e.g. if its engine failed.
+        void forfeit(const CBoard& board, const char *reason);
+
+        CSearchLimits limits() const;
+        void startClock() {m_moveStart = CTime();}
+
+        int winner() const {return m_winner;}  // Seen from white. Zero is a draw.
+        const char *reason() const {return m_reason;}
+
+    private:
+        bool end(int winner, const char *reason)
+            {m_winner = winner; m_reason = reason; return true;}
+
+        t_adjudication        m_adj;
+        CSearchLimits         m_limits;
+        bool                  m_clocks;
+        int                   m_clock[2];    // Time left for white and black
+        CTime                 m_moveStart;
+        std::vector<uint64_t> m_history;     // Positions since the last capture or pawn move
+        int                   m_ply;
+        int                   m_resignCount; // Consecutive plies with the same side lost
+        int                   m_resignSide;  // The side that is winning, seen from white
+        int                   m_drawCount;   // Consecutive plies with a drawn score
+        int                   m_winner;
+        const char           *m_reason;
+}; // end of CReferee
+
+#endif // _CREFEREE_H_
+
@@ -0,0 +1,201 @@
+#include <future>
+#include <memory>
+
+#include "CScorer.h"
+#include "CBoard.h"
+#include "ai.h"
+#include "parallel_for.h"
+
+#define BATCH_SIZE 16384 // Bytes per batch, about 256 lines
+#define IN_FLIGHT  4     // Batches per thread, that may be read but not yet written
+#define HASH_MB    16    // Hash table per thread, cleared for each position
+#define SEED       2022  // Random choice between equal moves, restarted for each position
+
+/***************************************************************
+ * constructor
+ ***************************************************************/
+CScorer::CScorer(int depth, unsigned int threads)
+    : m_depth(depth), m_threads(threads), m_os(NULL), m_cache(NULL),
+    m_mutex(), m_cond(), m_queue(), m_finished(false),
+    m_nextRead(0), m_nextWrite(0), m_done()
+{
+    if (m_threads == 0)
+        m_threads = pl::ThreadPool::instance().size();
+} // end of constructor
+
+
+/***************************************************************
+ * run
+ * Scores all positions of the file, and writes them to os.
+ ***************************************************************/
+bool CScorer::run(const CLineFile& file, std::ostream& os)
+{
+    m_os = &os;
+    m_finished = false;
+    m_nextRead = 0;
+    m_nextWrite = 0;
+
+    std::vector<std::future<void> > workers;
+    for (unsigned int i=0; i<m_threads; ++i)
+    {
+        workers.push_back(pl::ThreadPool::instance().submit([this]() { worker(); }));
+    }
+
+    CLineFile::t_range rest = file.all();
+    while (rest.begin < rest.end)
+    {
+        t_batch batch;
+        batch.range = CLineFile::head(rest, BATCH_SIZE);
+        rest.begin = batch.range.end;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // Don't read too far ahead of the slowest batch.
+        while (m_nextRead - m_nextWrite >= IN_FLIGHT * m_threads)
+            m_cond.wait(lock);
+
+        batch.index = m_nextRead++;
+        m_queue.push_back(batch);
+        m_cond.notify_all();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished = true;
+        m_cond.notify_all();
+    }
+
+    for (unsigned int i=0; i<workers.size(); ++i)
+    {
+        workers[i].get();
+    }
+
+    m_os->flush();
+    return !m_os->fail();
+} // end of run
+
+
+/***************************************************************
+ * epdScore
+ * The score as EPD operation: "ce" in centipawns, or "dm" with
+ * the number of moves to mate, as AI::scoreToUci converts it.
+ ***************************************************************/
+static std::string epdScore(int val, int depth)
+{
+    std::string uci = AI::scoreToUci(val, depth);
+    if (uci.compare(0, 5, "mate ") == 0)
+        return "dm " + uci.substr(5);
+    return "ce " + uci.substr(3);
+} // end of epdScore
+
+
+/***************************************************************
+ * worker
+ * Each worker scores positions on its own board. The AI, and
+ * with it the hash table, is only needed for searches. Each
+ * search starts afresh, so its score does not depend on the
+ * positions the worker happened to score before.
+ ***************************************************************/
+void CScorer::worker()
+{
+    CBoard board;
+    std::unique_ptr<AI> ai;
+    if (m_depth > 0)
+    {
+        ai.reset(new AI(board, SEED, HASH_MB));
+        CSearchLimits limits;
+        limits.depth = m_depth;
+        ai->setLimits(limits);
+    }
+
+    while (true)
+    {
+        t_batch batch;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_queue.empty() && !m_finished)
+                m_cond.wait(lock);
+            if (m_queue.empty())
+                return;
+            batch = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        std::vector<std::string> results;
+        CLineFile::forEachLine(batch.range, [&](const char *text, size_t length)
+        {
+            std::string line(text, length);
+
+            if (line.empty() || line[0] == '#')
+            {
+                results.push_back(line);
+                return;
+            }
+
+            if (board.read_from_fen(line.c_str()))
+            {
+                results.push_back("# error: " + line);
+                return;
+            }
+
+            if (m_depth > 0 && !board.hasLegalMove())
+            {
+                // Checkmate or stalemate, which the search can not tell apart
+                results.push_back(line + (board.isKingInCheck() ? " dm 0;" : " ce 0;"));
+                return;
+            }
+
+            int score;
+            int depth = 0;
+            CAnalysisCache::t_result cached;
+            if (m_depth > 0 && m_cache && m_cache->find(board, m_depth, cached))
+            {
+                score = cached.score;
+                depth = cached.depth;
+            }
+            else if (m_depth > 0)
+            {
+                ai->newGame();
+                ai->setSeed(SEED);
+                CAnalysisCache::t_result result;
+                result.move = ai->find_best_or_worst_move(true);
+                result.score = score = ai->getScore();
+                result.depth = depth = ai->getDepth();
+                result.nodes = ai->getNodes();
+                if (m_cache)
+                    m_cache->insert(board, result);
+            }
+            else
+            {
+                score = board.getValue();
+            }
+
+            results.push_back(line + " " + epdScore(score, depth) + ";");
+        });
+
+        write(batch.index, results);
+    }
+} // end of worker
+
+
+/***************************************************************
+ * write
+ * Writes all scored batches that are next in line.
+ ***************************************************************/
+void CScorer::write(unsigned long index, std::vector<std::string>& results)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done[index].swap(results);
+
+    while (!m_done.empty() && m_done.begin()->first == m_nextWrite)
+    {
+        std::vector<std::string>& lines = m_done.begin()->second;
+        for (unsigned int i=0; i<lines.size(); ++i)
+        {
+            *m_os << lines[i] << '\n';
+        }
+        m_done.erase(m_done.begin());
+        m_nextWrite++;
+    }
+    m_cond.notify_all();
+} // end of write
@@ -0,0 +1,81 @@
+#ifndef _CSCORER_H_
+#define _CSCORER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+#include "CLineFile.h"
+#include "CAnalysisCache.h"
+
+/***************************************************************
+ * declaration of CScorer
+ *
+ * This scores all positions in an EPD or FEN file, one position
+ * per line, using a number of worker threads.
+ *
+ * The file is memory-mapped, and cut into batches of lines at
+ * line ends, without copying. The batches are put on a work
+ * queue. Each worker scores a batch on its own board, either with
+ * the NNUE (depth 0) or with a search to a fixed depth. Finished
+ * batches are written in the same order as they were read, so the
+ * output corresponds line by line to the input:
+ *
+ *     <position> ce <score>;
+ *
+ * The score is in centipawns for the side to move. A search that
+ * finds a mate writes "dm <moves>" instead, negative if the side
+ * to move is mated. A position without legal moves is "dm 0" if
+ * mated, and "ce 0" if stalemate.
+ * Empty lines and comments are copied unchanged, and lines that
+ * can not be parsed are written as a comment.
+ *
+ * With an analysis cache, a position that was already searched to
+ * the depth is not searched again.
+ ***************************************************************/
+class CScorer
+{
+    public:
+        CScorer(int depth, unsigned int threads);
+
+        // Searches are looked up in the cache first, and the results
+        // are stored there.
+        void setCache(CAnalysisCache *cache) {m_cache = cache;}
+
+        bool run(const CLineFile& file, std::ostream& os);
+
+    private:
+        CScorer(const CScorer&) = delete;
+        CScorer& operator=(const CScorer&) = delete;
+
+        struct t_batch
+        {
+            t_batch() : index(), range() {}
+
+            unsigned long            index;
+            CLineFile::t_range       range;
+        };
+
+        void worker();
+        void write(unsigned long index, std::vector<std::string>& results);
+
+        int            m_depth;
+        unsigned int   m_threads;
+        std::ostream  *m_os;
+        CAnalysisCache *m_cache;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_cond;
+        std::deque<t_batch>     m_queue;        // Batches waiting to be scored
+        bool                    m_finished;     // No more batches will be queued
+        unsigned long           m_nextRead;     // Index of next batch to be read
+        unsigned long           m_nextWrite;    // Index of next batch to be written
+        std::map<unsigned long, std::vector<std::string> > m_done; // Scored, but not yet written
+}; // end of CScorer
+
+#endif // _CSCORER_H_
+
@@ -0,0 +1,68 @@
+#ifndef _CSEARCHLIMITS_H_
+#define _CSEARCHLIMITS_H_
+
+#include <algorithm>
+
+/***************************************************************
+ * declaration of CSearchLimits
+ *
+ * This is the budget for one search, as given by the UCI "go"
+ * command. A value of zero means no limit of that kind. The
+ * search stops at the first limit reached.
+ *
+ * A node or depth limit gives the same result on any machine,
+ * which makes experiments reproducible. Without any limit the
+ * search runs for DEFAULT_MOVETIME milliseconds.
+ ***************************************************************/
+struct CSearchLimits
+{
+    enum {DEFAULT_MOVETIME = 20000};
+
+    CSearchLimits() :
+        nodes(0), depth(0), movetime(0),
+        wtime(0), btime(0), winc(0), binc(0), movestogo(0),
+        infinite(false), ponder(false)
+    {}
+
+    unsigned long nodes;    // Nodes searched
+    int           depth;    // Plies
+    int           movetime; // Milliseconds for this move
+
+    // Remaining time on the clocks, in milliseconds
+    int           wtime;
+    int           btime;
+    int           winc;
+    int           binc;
+    int           movestogo;
+
+    bool          infinite; // Search until stopped
+    bool          ponder;   // No time limit until ponderhit, see AI::ponderhit()
+
+    // Milliseconds to spend on this move, or zero for no time limit.
+    int timeBudget(bool whiteToMove) const
+    {
+        if (infinite)
+            return 0;
+
+        if (movetime > 0)
+            return movetime;
+
+        int time = whiteToMove ? wtime : btime;
+        int inc  = whiteToMove ? winc  : binc;
+        if (time > 0)
+        {
+            int moves = movestogo > 0 ? movestogo : 30;
+            int budget = time/moves + inc*3/4;
+            // Keep a reserve, so the flag never falls.
+            return std::max(1, std::min(budget, time/2));
+        }
+
+        if (nodes == 0 && depth == 0)
+            return DEFAULT_MOVETIME;
+
+        return 0;
+    }
+}; // end of CSearchLimits
+
+#endif // _CSEARCHLIMITS_H_
+
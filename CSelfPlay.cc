@@ -0,0 +1,140 @@
+#include <iostream>
+#include <sstream>
+#include <chrono>
+
+#include "CSelfPlay.h"
+#include "parallel_for.h"
+
+// Bytes collected by a worker, before they are handed to the writer
+#define BLOCK_SIZE (1 << 20)
+
+/***************************************************************
+ * constructor
+ ***************************************************************/
+CSelfPlay::CSelfPlay(unsigned int threads, unsigned int hashMb)
+    : m_threads(threads), m_hashMb(hashMb), m_limits(), m_adj(),
+    m_openings(NULL), m_randomPlies(8), m_games(0), m_writer(),
+    m_nextGame(0), m_played(0), m_positions(0)
+{
+    if (m_threads == 0)
+        m_threads = pl::ThreadPool::instance().size();
+} // end of constructor
+
+
+/***************************************************************
+ * run
+ ***************************************************************/
+bool CSelfPlay::run(const char *fileName, unsigned int games)
+{
+    if (!m_writer.open(fileName))
+        return false;
+
+    m_games = games;
+    m_nextGame = 0;
+    m_played = 0;
+    m_positions = 0;
+
+    CTime timeStart;
+    pl::parallel_for(0, m_threads, [this](unsigned int id) { worker(id); });
+    bool ok = m_writer.close();
+
+    unsigned long millisecs = CTimeDiff(timeStart).millisecs();
+    std::cerr << m_played << " games, " << m_positions << " positions, "
+        << (millisecs ? m_positions*1000/millisecs : 0) << " positions/s" << std::endl;
+
+    return ok;
+} // end of run
+
+
+/***************************************************************
+ * playRandomMoves
+ * Plays up to plies random legal moves. Stops early, if there
+ * is no legal move.
+ ***************************************************************/
+static void playRandomMoves(CBoard& board, int plies, std::default_random_engine& generator)
+{
+    for (int ply = 0; ply < plies; ++ply)
+    {
+        CMoveList moves;
+        board.find_legal_moves(moves);
+
+        CMoveList legal;
+        for (unsigned int i=0; i<moves.size(); ++i)
+        {
+            board.make_move(moves[i]);
+            if (!board.isOtherKingInCheck())
+                legal.push_back(moves[i]);
+            board.undo_move(moves[i]);
+        }
+        if (legal.size() == 0)
+            return;
+
+        std::uniform_int_distribution<unsigned int> distribution(0, legal.size()-1);
+        board.make_move(legal[distribution(generator)]);
+    }
+} // end of playRandomMoves
+
+
+/***************************************************************
+ * worker
+ ***************************************************************/
+void CSelfPlay::worker(unsigned int id)
+{
+    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    std::default_random_engine generator (seed + id);
+
+    CBoard board;
+    AI white(board, seed + 2*id, m_hashMb);
+    AI black(board, seed + 2*id + 1, m_hashMb);
+    CReferee referee(m_adj, m_limits);
+
+    std::vector<t_trainingRecord> records;
+    std::vector<char> block;
+    block.reserve(BLOCK_SIZE + 1024*RECORD_SIZE);
+
+    while (true)
+    {
+        unsigned int i = m_nextGame++;
+        if (i >= m_games)
+            break;
+
+        if (m_openings && m_openings->size())
+        {
+            unsigned int opening = i % m_openings->size();
+            if (m_openings->setup(board, opening))
+            {
+                std::cerr << "Bad opening, game not played: " << m_openings->fen(opening) << std::endl;
+                continue;
+            }
+        }
+        else
+            board.newGame();
+        playRandomMoves(board, m_randomPlies, generator);
+
+        // Both sides play their best moves.
+        t_game game = {0, 1.0, true, true, -1};
+        records.clear();
+        match(board, white, black, game, referee, generator, &records);
+        m_played++;
+        m_positions += records.size();
+
+        for (unsigned int j=0; j<records.size(); ++j)
+        {
+            // The record is stored without the padding of the struct.
+            const t_trainingRecord& record = records[j];
+            const char *p = (const char *) &record;
+            block.insert(block.end(), p, p + sizeof(CPackedBoard));
+            block.insert(block.end(), (const char *) &record.score, (const char *) &record.score + 2);
+            block.push_back(record.result);
+            block.push_back(record.reserved);
+        }
+        if (block.size() >= BLOCK_SIZE)
+        {
+            m_writer.write(block);
+            block.reserve(BLOCK_SIZE + 1024*RECORD_SIZE);
+        }
+    }
+
+    m_writer.write(block);
+} // end of worker
+
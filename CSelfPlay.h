@@ -0,0 +1,60 @@
+#ifndef _CSELFPLAY_H_
+#define _CSELFPLAY_H_
+
+#include <atomic>
+
+#include "match.h"
+#include "CAsyncWriter.h"
+
+/***************************************************************
+ * declaration of CSelfPlay
+ *
+ * This generates training data for the NNUE by self-play. Games
+ * are played in parallel with match(), both sides playing their
+ * best moves within the search limits (normally a node budget).
+ * Each game starts from the start position or an opening, followed
+ * by a few random moves, so the games differ.
+ *
+ * Every position is written as a t_trainingRecord of RECORD_SIZE
+ * (36) bytes without padding: The CPackedBoard, the search score
+ * (int16), the result (int8) and a reserved byte. Each worker
+ * collects the records of its games, and hands them in large
+ * blocks to a CAsyncWriter, so the workers never wait for the disk.
+ ***************************************************************/
+class CSelfPlay
+{
+    public:
+        enum {RECORD_SIZE = sizeof(CPackedBoard) + 4};
+
+        CSelfPlay(unsigned int threads, unsigned int hashMb);
+
+        void setLimits(const CSearchLimits& limits) {m_limits = limits;}
+        void setAdjudication(const t_adjudication& adj) {m_adj = adj;}
+        void setOpenings(const COpenings *openings) {m_openings = openings;}
+        void setRandomPlies(int plies) {m_randomPlies = plies;}
+
+        // Plays the games, and writes the records to the file.
+        // Returns false, if the file could not be written.
+        bool run(const char *fileName, unsigned int games);
+
+    private:
+        CSelfPlay(const CSelfPlay&) = delete;
+        CSelfPlay& operator=(const CSelfPlay&) = delete;
+
+        void worker(unsigned int id);
+
+        unsigned int               m_threads;
+        unsigned int               m_hashMb;
+        CSearchLimits              m_limits;
+        t_adjudication             m_adj;
+        const COpenings           *m_openings;
+        int                        m_randomPlies;
+        unsigned int               m_games;
+        CAsyncWriter               m_writer;
+        std::atomic<unsigned int>  m_nextGame;
+        std::atomic<unsigned int>  m_played;     // Games not skipped for a bad opening
+        std::atomic<unsigned long> m_positions;
+}; // end of CSelfPlay
+
+#endif // _CSELFPLAY_H_
+
@@ -0,0 +1,340 @@
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "CServer.h"
+#include "CBoard.h"
+#include "CUci.h"
+#include "ai.h"
+#include "parallel_for.h"
+
+/***************************************************************
+ * constructor
+ * Starts the searchers. Zero means one per core.
+ ***************************************************************/
+CServer::CServer(unsigned int searchers, unsigned int hashMb)
+    : m_hashMb(hashMb), m_cache(NULL), m_searchers(),
+    m_mutex(), m_cond(), m_queue(), m_inFlight(), m_stopping(false)
+{
+    if (searchers == 0)
+        searchers = pl::ThreadPool::instance().size();
+
+    for (unsigned int i=0; i<searchers; ++i)
+    {
+        m_searchers.push_back(std::thread(&CServer::searcher, this, i));
+    }
+} // end of constructor
+
+
+/***************************************************************
+ * destructor
+ * The searchers finish the jobs on the queue first.
+ ***************************************************************/
+CServer::~CServer()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cond.notify_all();
+
+    for (unsigned int i=0; i<m_searchers.size(); ++i)
+    {
+        m_searchers[i].join();
+    }
+} // end of destructor
+
+
+/***************************************************************
+ * request
+ * Queues the search, unless the same one is already queued or
+ * running, and waits for the answer.
+ ***************************************************************/
+std::string CServer::request(const std::string& line)
+{
+    std::string fen = line;
+    std::string args;
+    size_t pos = line.find(" go");
+    if (pos != std::string::npos && (pos+3 == line.size() || line[pos+3] == ' '))
+    {
+        fen = line.substr(0, pos);
+        args = line.substr(pos+3);
+    }
+
+    // The position is read here, so all ways of writing it are the same job.
+    CBoard board;
+    if (board.read_from_fen(fen.c_str()))
+        return "error invalid position";
+
+    auto job = std::make_shared<t_job>();
+    job->fen = board.toFen();
+    job->limits = CUci::parseGo(args);
+    if (job->limits.infinite || job->limits.ponder)
+        return "error infinite search";
+
+    const CSearchLimits& limits = job->limits;
+    std::ostringstream key;
+    key << job->fen << " nodes " << limits.nodes << " depth " << limits.depth
+        << " movetime " << limits.movetime << " wtime " << limits.wtime
+        << " btime " << limits.btime << " winc " << limits.winc
+        << " binc " << limits.binc << " movestogo " << limits.movestogo;
+    job->key = key.str();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_inFlight.find(job->key);
+    if (it != m_inFlight.end())
+    {
+        job = it->second;
+    }
+    else
+    {
+        m_inFlight[job->key] = job;
+        m_queue.push_back(job);
+        m_cond.notify_all();
+    }
+
+    m_cond.wait(lock, [&job]() { return job->done; });
+    return job->answer;
+} // end of request
+
+
+/***************************************************************
+ * searcher
+ * Each searcher keeps its board and AI, and so its hash table,
+ * from job to job.
+ ***************************************************************/
+void CServer::searcher(unsigned int id)
+{
+    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    CBoard board;
+    AI ai(board, seed + id, m_hashMb);
+
+    while (true)
+    {
+        std::shared_ptr<t_job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty())
+                return;
+            job = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        board.read_from_fen(job->fen.c_str());
+        CAnalysisCache::t_result result;
+        std::string pv;
+        if (m_cache && job->limits.depth > 0 && m_cache->find(board, job->limits.depth, result))
+        {
+            pv = result.move.ToShortString();
+        }
+        else if (board.hasLegalMove())
+        {
+            ai.setLimits(job->limits);
+            result.move  = ai.find_best_or_worst_move(true);
+            result.score = ai.getScore();
+            result.depth = ai.getDepth();
+            result.nodes = ai.getNodes();
+            pv = ai.getPv().ToShortString();
+            if (m_cache)
+                m_cache->insert(board, result);
+        }
+
+        std::ostringstream answer;
+        if (result.move.Valid())
+        {
+            answer << "bestmove " << result.move.ToShortString()
+                << " score " << AI::scoreToUci(result.score, result.depth)
+                << " depth " << result.depth << " nodes " << result.nodes
+                << " pv " << pv;
+        }
+        else
+        {
+            // Checkmate or stalemate
+            answer << "bestmove 0000 score " << (board.isKingInCheck() ? "mate 0" : "cp 0")
+                << " depth 0 nodes 0 pv";
+        }
+
+        std::string text = answer.str();
+        while (text[text.size()-1] == ' ')
+            text.erase(text.size()-1); // The move list ends with a space
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            job->answer = text;
+            job->done = true;
+            m_inFlight.erase(job->key);
+        }
+        m_cond.notify_all();
+    }
+} // end of searcher
+
+#ifndef _WIN32
+
+/***************************************************************
+ * run
+ ***************************************************************/
+bool CServer::run(const std::string& address)
+{
+    // A client that goes away must not kill the server.
+    signal(SIGPIPE, SIG_IGN);
+
+    int fd;
+    if (address.find('/') != std::string::npos)
+    {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(addr.sun_path))
+        {
+            std::cerr << "Socket path too long: " << address << std::endl;
+            return false;
+        }
+        strcpy(addr.sun_path, address.c_str());
+        unlink(address.c_str()); // Left over from an earlier server
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)))
+        {
+            std::cerr << "Could not bind to " << address << ": " << strerror(errno) << std::endl;
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+    }
+    else
+    {
+        std::string host = "127.0.0.1";
+        std::string port = address;
+        size_t colon = address.rfind(':');
+        if (colon != std::string::npos)
+        {
+            host = address.substr(0, colon);
+            port = address.substr(colon+1);
+            if (host == "localhost")
+                host = "127.0.0.1";
+        }
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(atoi(port.c_str()));
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+        {
+            std::cerr << "Invalid address: " << address << std::endl;
+            return false;
+        }
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)))
+        {
+            std::cerr << "Could not bind to " << address << ": " << strerror(errno) << std::endl;
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+    }
+
+    if (listen(fd, 64))
+    {
+        std::cerr << "Could not listen on " << address << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    std::cerr << "Listening on " << address << " with " << m_searchers.size() << " searchers" << std::endl;
+
+    while (true)
+    {
+        int client = accept(fd, NULL, NULL);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::cerr << "Accept failed: " << strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+
+        // The connections run as long as the process.
+        std::thread(&CServer::connection, this, client).detach();
+    }
+} // end of run
+
+
+/***************************************************************
+ * connection
+ * Reads request lines from one client, and writes the answers.
+ ***************************************************************/
+void CServer::connection(int fd)
+{
+    std::string buffer;
+    char data[4096];
+    ssize_t n;
+    while ((n = recv(fd, data, sizeof(data), 0)) > 0)
+    {
+        buffer.append(data, n);
+
+        size_t pos;
+        while ((pos = buffer.find('\n')) != std::string::npos)
+        {
+            std::string line = buffer.substr(0, pos);
+            buffer.erase(0, pos+1);
+            while (!line.empty() && isspace((unsigned char) line[line.size()-1]))
+                line.erase(line.size()-1);
+
+            if (line.empty())
+                continue;
+            if (line == "quit")
+            {
+                close(fd);
+                return;
+            }
+
+            std::string answer = request(line) + '\n';
+            const char *p = answer.c_str();
+            size_t left = answer.size();
+            while (left)
+            {
+                ssize_t sent = send(fd, p, left, 0); // SIGPIPE is ignored, see run()
+                if (sent <= 0)
+                {
+                    close(fd);
+                    return;
+                }
+                p += sent;
+                left -= sent;
+            }
+        }
+    }
+    close(fd);
+} // end of connection
+
+#else // _WIN32
+
+bool CServer::run(const std::string& address)
+{
+    std::cerr << "The server is not supported on Windows: " << address << std::endl;
+    return false;
+}
+
+void CServer::connection(int)
+{
+}
+
+#endif // _WIN32
+
@@ -0,0 +1,91 @@
+#ifndef _CSERVER_H_
+#define _CSERVER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "CSearchLimits.h"
+#include "CAnalysisCache.h"
+
+/***************************************************************
+ * declaration of CServer
+ *
+ * This is a long-running analysis server. It listens on a Unix
+ * domain socket or a TCP port on localhost, and answers one line
+ * for every request line:
+ *
+ *     <fen> [go <limits>]
+ *     bestmove <move> score <cp x|mate y> depth <d> nodes <n> pv <moves>
+ *
+ * The limits are those of the UCI "go" command, e.g. "go depth 8"
+ * or "go movetime 500". Infinite searches are not allowed. A
+ * request that can not be handled is answered with "error <reason>".
+ * "quit" closes the connection.
+ *
+ * The requests of a connection are answered in turn. Requests from
+ * all connections are put on one queue, and are searched by a fixed
+ * number of searchers, each with its own board and AI. The hash
+ * tables stay warm from request to request, and the NNUE is loaded
+ * only once. A request for a position and limits, that are already
+ * waiting or being searched, gets the answer of that search.
+ * With an analysis cache, a position that was already searched to
+ * the depth of the request is answered from the cache, with the
+ * best move as the PV.
+ *
+ * Only supported on POSIX systems. On Windows run() fails.
+ ***************************************************************/
+class CServer
+{
+    public:
+        CServer(unsigned int searchers, unsigned int hashMb = 128);
+        ~CServer();
+
+        // Listens on address, which is the path of a Unix domain
+        // socket, or "[host:]port" for TCP, by default on localhost.
+        // Only returns, if the server can not listen or accept.
+        bool run(const std::string& address);
+
+        // Answers one request line. May be called from any thread.
+        std::string request(const std::string& line);
+
+        // Requests with a depth limit are looked up in the cache first,
+        // and the results of all searches are stored there.
+        void setCache(CAnalysisCache *cache) {m_cache = cache;}
+
+    private:
+        CServer(const CServer&) = delete;
+        CServer& operator=(const CServer&) = delete;
+
+        struct t_job
+        {
+            t_job() : key(), fen(), limits(), done(false), answer() {}
+
+            std::string   key;      // Position and limits, to find duplicates
+            std::string   fen;
+            CSearchLimits limits;
+            bool          done;
+            std::string   answer;
+        };
+
+        void searcher(unsigned int id);
+        void connection(int fd);
+
+        unsigned int             m_hashMb;
+        CAnalysisCache          *m_cache;
+        std::vector<std::thread> m_searchers;
+
+        std::mutex               m_mutex;       // Protects everything below
+        std::condition_variable  m_cond;
+        std::deque<std::shared_ptr<t_job> >              m_queue;    // Jobs not yet started
+        std::map<std::string, std::shared_ptr<t_job> >   m_inFlight; // Jobs not yet done, by key
+        bool                     m_stopping;
+}; // end of CServer
+
+#endif // _CSERVER_H_
+
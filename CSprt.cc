@@ -0,0 +1,53 @@
+#include <math.h>
+
+#include "CSprt.h"
+
+/***************************************************************
+ * Expected score of a player, that is elo stronger.
+ ***************************************************************/
+static double eloToScore(double elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo/400.0));
+} // end of eloToScore
+
+
+/***************************************************************
+ * constructor
+ ***************************************************************/
+CSprt::CSprt(double elo0, double elo1, double alpha, double beta)
+    : m_score0(eloToScore(elo0)), m_score1(eloToScore(elo1)),
+    m_lower(log(beta / (1.0 - alpha))), m_upper(log((1.0 - beta) / alpha))
+{
+} // end of constructor
+
+
+/***************************************************************
+ * llr
+ * Returns the log-likelihood ratio of H1 against H0.
+ ***************************************************************/
+double CSprt::llr(int losses, int draws, int wins) const
+{
+    double n = losses + draws + wins + 1.5;
+    double w = (wins   + 0.5) / n;
+    double d = (draws  + 0.5) / n;
+
+    double score = w + d/2;
+    double var = w + d/4 - score*score;
+
+    return n * (m_score1 - m_score0) * (2*score - m_score0 - m_score1) / (2*var);
+} // end of llr
+
+
+/***************************************************************
+ * status
+ ***************************************************************/
+CSprt::e_status CSprt::status(int losses, int draws, int wins) const
+{
+    double val = llr(losses, draws, wins);
+    if (val <= m_lower)
+        return sprtH0;
+    if (val >= m_upper)
+        return sprtH1;
+    return sprtContinue;
+} // end of status
+
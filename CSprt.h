@@ -0,0 +1,46 @@
+#ifndef _CSPRT_H_
+#define _CSPRT_H_
+
+/***************************************************************
+ * declaration of CSprt
+ *
+ * This is a sequential probability ratio test on the result of a
+ * series of games. It decides between the hypotheses
+ *     H0: The player is elo0 stronger than the opponent
+ *     H1: The player is elo1 stronger than the opponent
+ * with error probabilities alpha (accept H1 when H0 is true) and
+ * beta (accept H0 when H1 is true).
+ *
+ * The log-likelihood ratio uses the normal approximation of the
+ * score (win=1, draw=1/2, loss=0). Half a game is added to each
+ * outcome, so the variance is never zero, even if e.g. all games
+ * are lost.
+ ***************************************************************/
+class CSprt
+{
+    public:
+        typedef enum
+        {
+            sprtH0 = -1,  // Accept H0
+            sprtContinue, // Not decided yet
+            sprtH1        // Accept H1
+        } e_status;
+
+        CSprt(double elo0 = 0.0, double elo1 = 50.0,
+                double alpha = 0.05, double beta = 0.05);
+
+        double   llr(int losses, int draws, int wins) const;
+        e_status status(int losses, int draws, int wins) const;
+
+        double lowerBound() const {return m_lower;}
+        double upperBound() const {return m_upper;}
+
+    private:
+        double m_score0; // Expected score under H0
+        double m_score1; // Expected score under H1
+        double m_lower;
+        double m_upper;
+}; // end of CSprt
+
+#endif // _CSPRT_H_
+
@@ -1,46 +1,46 @@
 #ifndef _CTIME_H_
 #define _CTIME_H_
 
-#include <time.h>
+#include <chrono>
 
+// This measures wall clock time. Using CPU time would make the time
+// limits depend on machine load, and on the number of threads running.
 class CTime
 {
     public:
         friend class CTimeDiff;
 
-        CTime() : m_time(clock())
+        CTime() : m_time(std::chrono::steady_clock::now())
         {
         }
 
         CTime& operator += (int timeMs)
         {
-            m_time += timeMs * (CLOCKS_PER_SEC / 1000);
+            m_time += std::chrono::milliseconds(timeMs);
             return *this;
         }
 
-        bool operator < (const CTime& rhs)
+        bool operator < (const CTime& rhs) const
         {
             return m_time < rhs.m_time;
         }
 
 
     private:
-        clock_t m_time;
+        std::chrono::steady_clock::time_point m_time;
 }; // end of class CTime
 
 class CTimeDiff
 {
     public:
         CTimeDiff(const CTime& start) :
-            m_time(clock() - start.m_time)
+            m_time(std::chrono::steady_clock::now() - start.m_time)
             {}
 
-        unsigned int millisecs() const {return m_time / (CLOCKS_PER_SEC / 1000);}
+        unsigned int millisecs() const {return std::chrono::duration_cast<std::chrono::milliseconds>(m_time).count();}
 
     private:
-        clock_t m_time;
+        std::chrono::steady_clock::duration m_time;
 }; // end of class CTimeDiff
 
 #endif // _CTIME_H_
-
-
@@ -0,0 +1,494 @@
+#include <sstream>
+#include <cstdlib>
+
+#include "CUci.h"
+#include "CMoveList.h"
+
+/***************************************************************
+ * constructor
+ ***************************************************************/
+CUci::CUci(CBoard& board, unsigned seed, unsigned hashMb)
+    : m_board(board), m_ai(board, seed, hashMb), m_os(NULL), m_uciMode(false),
+    m_positionBase(), m_positionMoves(),
+    m_mutex(), m_cond(), m_queue(), m_inputEnd(false), m_stopped(false), m_ponderhit(false),
+    m_outMutex(), m_searchThread()
+{
+} // end of constructor
+
+
+/***************************************************************
+ * destructor
+ ***************************************************************/
+CUci::~CUci()
+{
+    stopSearch();
+    waitSearch();
+} // end of destructor
+
+
+/***************************************************************
+ * run
+ ***************************************************************/
+int CUci::run(std::istream& is, std::ostream& os)
+{
+    m_os = &os;
+    std::thread readerThread(&CUci::reader, this, std::ref(is));
+
+    while (true) // Repeat until quit
+    {
+        if (!m_uciMode)
+        {
+            os << m_board;
+            os << "Input command : " << std::flush;
+        }
+
+        std::string str;
+        if (!nextCommand(str))
+        {
+            // End of input. Let the last search finish, unless it never would.
+            if (m_ai.getLimits().infinite || m_ai.getLimits().ponder)
+                stopSearch();
+            break;
+        }
+
+        if (!m_uciMode)
+        {
+            os << std::endl;
+        }
+
+        if (!handle(str))
+            break;
+    }
+
+    waitSearch();
+    readerThread.join();
+    return 0;
+} // end of run
+
+
+/***************************************************************
+ * reader
+ * Runs on its own thread, until "quit" or the end of the input.
+ ***************************************************************/
+void CUci::reader(std::istream& is)
+{
+    std::string line;
+    while (getline(is, line))
+    {
+        while (!line.empty() && isspace((unsigned char) line[line.size()-1]))
+            line.erase(line.size()-1);
+
+        if (line == "stop" || line == "quit")
+            stopSearch();
+        if (line == "ponderhit")
+            ponderhit();
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queue.push_back(line);
+        }
+        m_cond.notify_all();
+
+        if (line == "quit")
+            return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_inputEnd = true;
+    m_cond.notify_all();
+} // end of reader
+
+
+/***************************************************************
+ * nextCommand
+ * Waits for the next command. Returns false at the end of input.
+ ***************************************************************/
+bool CUci::nextCommand(std::string& str)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this]() { return !m_queue.empty() || m_inputEnd; });
+    if (m_queue.empty())
+        return false;
+
+    str = m_queue.front();
+    m_queue.pop_front();
+    return true;
+} // end of nextCommand
+
+
+/***************************************************************
+ * handle
+ * Handles one command. Returns false on "quit".
+ ***************************************************************/
+bool CUci::handle(const std::string& str)
+{
+    std::ostream& os = *m_os;
+
+    if (str == "quit")
+    {
+        // As for "stop", a "go" in the queue may have started a search
+        stopSearch();
+        return false;
+    }
+    if (str == "stop")
+    {
+        // Already done by the reader, but the search may have been
+        // started by a "go" that was still in the queue.
+        stopSearch();
+    }
+    if (str == "ponderhit")
+    {
+        ponderhit(); // The same
+    }
+    if (str == "uci")
+    {
+#define DEF_STR(x) #x
+#define DEF_XSTR(x) DEF_STR(x)
+        send("id name " DEF_XSTR(NAME));
+        send("id author MJ");
+        send("option name Ponder type check default false");
+        send("option name MultiPV type spin default 1 min 1 max 256");
+        send("option name HashFile type string default <empty>");
+        send(std::string("info string Hash on ") + m_ai.hashTable().pageMode());
+        send("uciok");
+        waitSearch();
+        m_uciMode = true;
+        m_ai.setInfo([this](const std::string& line) { send("info " + line); });
+    }
+    if (str == "isready")
+    {
+        send("readyok");
+    }
+    if (str == "ucinewgame")
+    {
+        waitSearch();
+        m_board.newGame();
+        m_positionBase.clear();
+    }
+    if (str.compare(0, 10, "setoption ") == 0)
+    {
+        waitSearch();
+        setOption(str.substr(10));
+    }
+    if (str.compare(0, 9, "savehash ") == 0)
+    {
+        waitSearch();
+        std::string fileName = str.substr(9);
+        send(m_ai.hashTable().save(fileName.c_str()) ?
+                "info string Hash saved to " + fileName : "info string Could not save hash to " + fileName);
+    }
+    if (str.compare(0, 9, "loadhash ") == 0)
+    {
+        waitSearch();
+        std::string fileName = str.substr(9);
+        send(m_ai.hashTable().load(fileName.c_str()) ?
+                "info string Hash loaded from " + fileName : "info string Could not load hash from " + fileName);
+    }
+    if (str.compare(0, 9, "position ") == 0)
+    {
+        waitSearch();
+        position(str.substr(9));
+    }
+
+    if (str.compare(0, 5, "move ") == 0)
+    {
+        waitSearch();
+        CMove move;
+
+        if (move.FromString(str.c_str()+5) == NULL)
+        {
+            os << "Try again. Use long notation, e.g. e2e4" << std::endl;
+            return true;
+        }
+
+        if (m_board.IsMoveValid(move))
+        {
+            m_board.make_move(move);
+            bool check = m_board.isOtherKingInCheck();
+            m_board.undo_move(move);
+            if (check)
+            {
+                os << "You are in CHECK. Play another move." << std::endl;
+                return true;
+            }
+
+            os << "You move : " << move << std::endl;
+            m_board.make_move(move);
+            m_positionBase.clear();
+        }
+    } // end of "move "
+
+    if (str.compare(0, 2, "go") == 0)
+    {
+        go(parseGo(str.substr(2)));
+    } // end of "go"
+
+    if (str == "show")
+    {
+        waitSearch();
+        CMoveList moves;
+        m_board.find_legal_moves(moves);
+        for (unsigned int i=0; i<moves.size(); ++i)
+        {
+            const CMove & move = moves[i];
+            m_board.make_move(move);
+            if (!m_board.isOtherKingInCheck())
+            {
+                os << move << " ";
+            }
+            m_board.undo_move(move);
+        }
+        os << std::endl;
+    } // end of "show"
+
+    return true;
+} // end of handle
+
+
+/***************************************************************
+ * position
+ * Sets up the board from the arguments of a "position" command.
+ * A GUI sends the whole game before every move. If the position
+ * only differs from the last one in the last few moves, those
+ * moves are taken back and the new ones are played, instead of
+ * replaying the whole game.
+ ***************************************************************/
+void CUci::position(const std::string& args)
+{
+    size_t pos = args.find(" moves");
+    std::string base = args.substr(0, pos);
+
+    std::vector<CMove> moves;
+    if (pos != std::string::npos)
+    {
+        CMove move;
+        const char *p = args.c_str() + pos + 6;
+        while (*p == ' ')
+            p++;
+        while ((p = move.FromString(p)) != NULL)
+            moves.push_back(move);
+    }
+
+    // The number of moves the board has in common with the new position
+    unsigned int common = 0;
+    if (base == m_positionBase)
+    {
+        while (common < moves.size() && common < m_positionMoves.size() &&
+                moves[common].From() == m_positionMoves[common].From() &&
+                moves[common].To() == m_positionMoves[common].To() &&
+                moves[common].GetPromoted() == m_positionMoves[common].GetPromoted())
+            common++;
+
+        while (m_positionMoves.size() > common)
+        {
+            m_board.undo_move(m_positionMoves.back());
+            m_positionMoves.pop_back();
+        }
+    }
+    else
+    {
+        m_positionBase.clear();
+        m_positionMoves.clear();
+        if (base == "startpos")
+        {
+            m_board.newGame();
+        }
+        else if (base.compare(0, 4, "fen ") != 0 || m_board.read_from_fen(base.substr(4).c_str()))
+        {
+            send("info string Error reading position: " + base);
+            return;
+        }
+        m_positionBase = base;
+    }
+
+    for (unsigned int i = common; i < moves.size(); ++i)
+    {
+        if (!m_board.isMoveLegal(moves[i]))
+        {
+            send("info string Invalid move " + moves[i].ToShortString());
+            break;
+        }
+        m_board.make_move(moves[i]);
+        m_positionMoves.push_back(moves[i]);
+    }
+} // end of position
+
+
+/***************************************************************
+ * setOption
+ * Handles "setoption name <id> [value <x>]". Unknown options are
+ * ignored, as the GUI may send options of other engines.
+ ***************************************************************/
+void CUci::setOption(const std::string& args)
+{
+    std::istringstream is(args);
+    std::string token, name, value;
+    std::string *word = NULL;
+    while (is >> token)
+    {
+        if (token == "name")
+            word = &name;
+        else if (token == "value")
+            word = &value;
+        else if (word)
+            *word += (word->empty() ? "" : " ") + token;
+    }
+
+    if (name == "MultiPV")
+        m_ai.setMultiPv(std::min(256, std::max(1, atoi(value.c_str()))));
+    if (name == "HashFile" && !value.empty() && value != "<empty>")
+    {
+        if (!m_ai.hashTable().mapFile(value.c_str()))
+            send("info string Could not map hash file " + value);
+    }
+} // end of setOption
+
+
+/***************************************************************
+ * parseGo
+ ***************************************************************/
+CSearchLimits CUci::parseGo(const std::string& args)
+{
+    CSearchLimits limits;
+    std::istringstream is(args);
+    std::string token;
+    while (is >> token)
+    {
+        if      (token == "wtime")     is >> limits.wtime;
+        else if (token == "btime")     is >> limits.btime;
+        else if (token == "winc")      is >> limits.winc;
+        else if (token == "binc")      is >> limits.binc;
+        else if (token == "movestogo") is >> limits.movestogo;
+        else if (token == "depth")     is >> limits.depth;
+        else if (token == "nodes")     is >> limits.nodes;
+        else if (token == "movetime")  is >> limits.movetime;
+        else if (token == "infinite")  limits.infinite = true;
+        else if (token == "ponder")    limits.ponder = true;
+        // Anything else is ignored.
+    }
+    return limits;
+} // end of parseGo
+
+
+/***************************************************************
+ * go
+ * Starts a search on its own thread. At the console, the engine
+ * plays the move, so go waits for it.
+ ***************************************************************/
+void CUci::go(const CSearchLimits& limits)
+{
+    waitSearch();
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopped = false;
+        m_ponderhit = false;
+    }
+    m_ai.clearStop();
+    m_ai.setLimits(limits);
+    m_searchThread = std::thread(&CUci::search, this, limits);
+
+    if (!m_uciMode)
+        waitSearch();
+} // end of go
+
+
+/***************************************************************
+ * search
+ * Runs on the search thread.
+ ***************************************************************/
+void CUci::search(CSearchLimits limits)
+{
+    CMove best_move = m_ai.find_best_or_worst_move(true);
+
+    // An infinite search may only end with "stop", and
+    // pondering with "stop" or "ponderhit".
+    if (limits.infinite || limits.ponder)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this, &limits]()
+            { return m_stopped || (m_ponderhit && !limits.infinite); });
+    }
+
+    if (!best_move.Valid())
+    {
+        if (m_uciMode)
+        {
+            send("bestmove 0000");
+        }
+        else if (m_board.isOtherKingInCheck() || m_board.isKingInCheck())
+        {
+            // Oops. No legal move was found
+            send("I am checkmated. YOU WON!");
+        }
+        else
+        {
+            send("I have no legal moves. It is a STALE MATE!");
+        }
+        return;
+    }
+
+    std::string answer = "bestmove " + best_move.ToShortString();
+    const CMoveList& pv = m_ai.getPv();
+    if (pv.size() >= 2 && pv[0] == best_move)
+        answer += " ponder " + pv[1].ToShortString();
+    send(answer);
+
+    if (!m_uciMode)
+    {
+        m_board.make_move(best_move);
+        m_positionBase.clear();
+    }
+} // end of search
+
+
+/***************************************************************
+ * stopSearch
+ * May be called from any thread.
+ ***************************************************************/
+void CUci::stopSearch()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_ai.stop();
+    m_cond.notify_all();
+} // end of stopSearch
+
+
+/***************************************************************
+ * ponderhit
+ * May be called from any thread.
+ ***************************************************************/
+void CUci::ponderhit()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ponderhit = true;
+    }
+    m_ai.ponderhit();
+    m_cond.notify_all();
+} // end of ponderhit
+
+
+/***************************************************************
+ * waitSearch
+ ***************************************************************/
+void CUci::waitSearch()
+{
+    if (m_searchThread.joinable())
+        m_searchThread.join();
+} // end of waitSearch
+
+
+/***************************************************************
+ * send
+ * Writes one line of output. May be called from any thread.
+ ***************************************************************/
+void CUci::send(const std::string& line)
+{
+    std::unique_lock<std::mutex> lock(m_outMutex);
+    *m_os << line << std::endl;
+} // end of send
+
@@ -0,0 +1,95 @@
+#ifndef _CUCI_H_
+#define _CUCI_H_
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "CBoard.h"
+#include "ai.h"
+#include "CSearchLimits.h"
+
+/***************************************************************
+ * declaration of CUci
+ *
+ * This is the front end of the engine, for a UCI GUI or for a
+ * human at the console. Three threads are involved:
+ *
+ * - The reader thread reads the input line by line, and puts the
+ *   commands on a queue. "stop" and "quit" also stop a running
+ *   search at once, so they are never held up behind other work.
+ * - The main thread (run) takes the commands from the queue, and
+ *   answers them. It never searches, so e.g. "isready" is answered
+ *   at once, also during a search.
+ * - "go" starts a search thread, which writes "bestmove" when the
+ *   search is done. A command that changes the position first
+ *   waits for the search to finish.
+ *
+ * With "go ponder" the engine searches the position after the
+ * expected reply, without a time limit. On "ponderhit" the same
+ * search goes on with the normal time limit, and the hash table
+ * and iterations done so far are kept. The ponder move sent with
+ * "bestmove" is the second move of the principal variation.
+ *
+ * "position" only plays the moves, that are new since the last
+ * "position" command (see position()).
+ *
+ * Besides UCI, "savehash <file>" and "loadhash <file>" save and
+ * load the transposition table. With the option HashFile the table
+ * is kept in a file all the time (see CHashTable::mapFile).
+ *
+ * At the end of the input, a running search is finished before
+ * run() returns, so a script of commands may be piped in.
+ ***************************************************************/
+class CUci
+{
+    public:
+        CUci(CBoard& board, unsigned seed, unsigned hashMb = 128);
+        ~CUci();
+
+        // Handles commands from is until "quit" or the end of is.
+        int run(std::istream& is, std::ostream& os);
+
+        // Reads the arguments of a "go" command.
+        static CSearchLimits parseGo(const std::string& args);
+
+    private:
+        CUci(const CUci&) = delete;
+        CUci& operator=(const CUci&) = delete;
+
+        void reader(std::istream& is);
+        bool nextCommand(std::string& str);
+        bool handle(const std::string& str);
+        void setOption(const std::string& args);
+        void position(const std::string& args);
+        void go(const CSearchLimits& limits);
+        void search(CSearchLimits limits);
+        void stopSearch();
+        void ponderhit();
+        void waitSearch();
+        void send(const std::string& line);
+
+        CBoard&                  m_board;
+        AI                       m_ai;
+        std::ostream            *m_os;
+        bool                     m_uciMode;
+        std::string              m_positionBase;  // "startpos" or "fen ..." on the board, if known
+        std::vector<CMove>       m_positionMoves; // Moves played on the board since then
+
+        std::mutex               m_mutex;       // Protects the queue, m_stopped and m_ponderhit
+        std::condition_variable  m_cond;
+        std::deque<std::string>  m_queue;       // Commands read, but not yet handled
+        bool                     m_inputEnd;    // The reader has finished
+        bool                     m_stopped;     // "stop" was received during the search
+        bool                     m_ponderhit;   // "ponderhit" was received during the search
+
+        std::mutex               m_outMutex;    // One line of output at a time
+        std::thread              m_searchThread;
+}; // end of CUci
+
+#endif // _CUCI_H_
+
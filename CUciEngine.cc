@@ -0,0 +1,272 @@
+#include <iostream>
+#include <sstream>
+#include <mutex>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
+#include "CUciEngine.h"
+
+// Time allowed for an engine to answer, beyond its own budget.
+#define MARGIN_MS 5000
+
+#ifndef _WIN32
+
+// Pipes and fork are serialized, so a child never inherits the
+// pipes of another engine before they are marked close-on-exec.
+static std::mutex forkMutex;
+
+/***************************************************************
+ * start
+ ***************************************************************/
+bool CUciEngine::start(const std::string& command)
+{
+    stop();
+
+    // A dead engine must not kill us on the next write.
+    signal(SIGPIPE, SIG_IGN);
+
+    int to[2], from[2];
+    {
+        std::unique_lock<std::mutex> lock(forkMutex);
+
+        if (pipe(to))
+            return false;
+        if (pipe(from))
+        {
+            close(to[0]);
+            close(to[1]);
+            return false;
+        }
+        fcntl(to[1], F_SETFD, FD_CLOEXEC);
+        fcntl(from[0], F_SETFD, FD_CLOEXEC);
+
+        m_pid = fork();
+        if (m_pid == 0)
+        {
+            // The child. Only async-signal-safe calls from here.
+            // It gets a process group of its own, so the shell and the
+            // engine are killed together, and SIGPIPE as usual, so it
+            // ends when we close the pipes.
+            setpgid(0, 0);
+            signal(SIGPIPE, SIG_DFL);
+            dup2(to[0], STDIN_FILENO);
+            dup2(from[1], STDOUT_FILENO);
+            close(to[0]);
+            close(from[1]);
+            execl("/bin/sh", "sh", "-c", command.c_str(), (char *) NULL);
+            _exit(127);
+        }
+        close(to[0]);
+        close(from[1]);
+    }
+
+    m_to = to[1];
+    m_from = from[0];
+    if (m_pid < 0)
+    {
+        stop();
+        return false;
+    }
+
+    std::string line;
+    if (!send("uci") || !waitFor("uciok", MARGIN_MS, line))
+    {
+        std::cerr << "Engine did not answer uci: " << command << std::endl;
+        stop();
+        return false;
+    }
+    return newGame();
+} // end of start
+
+
+/***************************************************************
+ * stop
+ ***************************************************************/
+void CUciEngine::stop()
+{
+    if (m_to >= 0)
+    {
+        send("quit");
+        close(m_to);
+        m_to = -1;
+    }
+    if (m_from >= 0)
+    {
+        close(m_from);
+        m_from = -1;
+    }
+    if (m_pid > 0)
+    {
+        // Give the engine a moment to quit, before killing it.
+        for (int i = 0; i < 100 && waitpid(m_pid, NULL, WNOHANG) == 0; ++i)
+            usleep(10000);
+        if (waitpid(m_pid, NULL, WNOHANG) == 0)
+        {
+            kill(m_pid, SIGKILL);
+            waitpid(m_pid, NULL, 0);
+        }
+        kill(-m_pid, SIGKILL); // Anything the engine left behind
+    }
+    m_pid = -1;
+    m_buffer.clear();
+} // end of stop
+
+
+/***************************************************************
+ * send
+ ***************************************************************/
+bool CUciEngine::send(const std::string& line)
+{
+    std::string data = line + '\n';
+    const char *p = data.c_str();
+    size_t left = data.size();
+    while (left)
+    {
+        ssize_t n = write(m_to, p, left);
+        if (n <= 0)
+            return false;
+        p += n;
+        left -= n;
+    }
+    return true;
+} // end of send
+
+
+/***************************************************************
+ * readLine
+ * Returns false after the deadline, or when the engine has exited.
+ ***************************************************************/
+bool CUciEngine::readLine(std::string& line, const CTime& deadline)
+{
+    while (true)
+    {
+        size_t pos = m_buffer.find('\n');
+        if (pos != std::string::npos)
+        {
+            line = m_buffer.substr(0, pos);
+            if (!line.empty() && line[line.size()-1] == '\r')
+                line.erase(line.size()-1);
+            m_buffer.erase(0, pos+1);
+            return true;
+        }
+
+        CTime now;
+        if (deadline < now)
+            return false;
+
+        struct pollfd pfd = {m_from, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+
+        char buf[4096];
+        ssize_t n = read(m_from, buf, sizeof(buf));
+        if (n <= 0)
+            return false;
+        m_buffer.append(buf, n);
+    }
+} // end of readLine
+
+#else // _WIN32
+
+bool CUciEngine::start(const std::string& command)
+{
+    std::cerr << "External engines are not supported on Windows: " << command << std::endl;
+    return false;
+}
+
+void CUciEngine::stop()
+{
+}
+
+bool CUciEngine::send(const std::string&)
+{
+    return false;
+}
+
+bool CUciEngine::readLine(std::string&, const CTime&)
+{
+    return false;
+}
+
+#endif // _WIN32
+
+
+/***************************************************************
+ * waitFor
+ * Reads lines until one starts with token. The engine name is
+ * picked up on the way. The timeout is for all lines together,
+ * so an engine that keeps sending "info" lines is timed out too.
+ ***************************************************************/
+bool CUciEngine::waitFor(const std::string& token, int timeoutMs, std::string& line)
+{
+    CTime deadline;
+    deadline += timeoutMs;
+
+    while (readLine(line, deadline))
+    {
+        if (line.compare(0, 8, "id name ") == 0)
+            m_name = line.substr(8);
+        if (line.compare(0, token.size(), token) == 0)
+            return true;
+    }
+    return false;
+} // end of waitFor
+
+
+/***************************************************************
+ * newGame
+ ***************************************************************/
+bool CUciEngine::newGame()
+{
+    std::string line;
+    return send("ucinewgame") && send("isready") && waitFor("readyok", MARGIN_MS, line);
+} // end of newGame
+
+
+/***************************************************************
+ * go
+ ***************************************************************/
+bool CUciEngine::go(const std::string& position, const CSearchLimits& limits, std::string& bestMove)
+{
+    std::ostringstream cmd;
+    int timeoutMs;
+    if (limits.wtime > 0 || limits.btime > 0)
+    {
+        cmd << "go wtime " << limits.wtime << " btime " << limits.btime
+            << " winc " << limits.winc << " binc " << limits.binc;
+        if (limits.movestogo)
+            cmd << " movestogo " << limits.movestogo;
+        timeoutMs = std::max(limits.wtime, limits.btime);
+    }
+    else
+    {
+        cmd << "go";
+        if (limits.nodes)
+            cmd << " nodes " << limits.nodes;
+        if (limits.depth)
+            cmd << " depth " << limits.depth;
+        if (limits.movetime)
+            cmd << " movetime " << limits.movetime;
+        if (!limits.nodes && !limits.depth && !limits.movetime)
+            cmd << " movetime " << (int) CSearchLimits::DEFAULT_MOVETIME;
+        // Node and depth limits have no time budget, so allow a generous one.
+        timeoutMs = limits.movetime ? limits.movetime : 60000;
+    }
+
+    std::string line;
+    if (!send("position " + position) || !send(cmd.str()) ||
+            !waitFor("bestmove", timeoutMs + MARGIN_MS, line))
+        return false;
+
+    std::istringstream is(line);
+    std::string token;
+    is >> token >> bestMove;
+    return !bestMove.empty();
+} // end of go
+
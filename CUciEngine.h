@@ -0,0 +1,57 @@
+#ifndef _CUCIENGINE_H_
+#define _CUCIENGINE_H_
+
+#include <string>
+
+#include "CSearchLimits.h"
+#include "CTime.h"
+
+/***************************************************************
+ * declaration of CUciEngine
+ *
+ * This runs an external UCI engine as a child process, and talks
+ * to it over a pair of pipes. The command is run by /bin/sh, so
+ * it may contain arguments. Each CUciEngine owns one process, so
+ * several games can run at the same time, one per worker.
+ *
+ * Only supported on POSIX systems. On Windows start() fails.
+ ***************************************************************/
+class CUciEngine
+{
+    public:
+        CUciEngine() : m_pid(-1), m_to(-1), m_from(-1), m_buffer(), m_name() {}
+        ~CUciEngine() {stop();}
+
+        // Starts the engine, and waits for "uciok". Returns false on error.
+        bool start(const std::string& command);
+        void stop();
+        bool running() const {return m_pid > 0;}
+
+        // Sends "ucinewgame", and waits until the engine is ready.
+        // Returns false, if the engine fails or is too slow.
+        bool newGame();
+
+        // Sends the position (e.g. "startpos moves e2e4") and the
+        // limits, and waits for the best move in long algebraic
+        // notation. Returns false, if the engine fails or is too slow.
+        bool go(const std::string& position, const CSearchLimits& limits, std::string& bestMove);
+
+        const std::string& name() const {return m_name;}
+
+    private:
+        CUciEngine(const CUciEngine&) = delete;
+        CUciEngine& operator=(const CUciEngine&) = delete;
+
+        bool send(const std::string& line);
+        bool readLine(std::string& line, const CTime& deadline);
+        bool waitFor(const std::string& token, int timeoutMs, std::string& line);
+
+        int         m_pid;
+        int         m_to;     // Pipe to the engine's stdin
+        int         m_from;   // Pipe from the engine's stdout
+        std::string m_buffer; // Output read, but not yet returned as a line
+        std::string m_name;
+}; // end of CUciEngine
+
+#endif // _CUCIENGINE_H_
+
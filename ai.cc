@@ -1,12 +1,297 @@
 #include <iostream>
 #include <stdlib.h>
 #include <time.h>
+#include <algorithm>
+#include <sstream>
 
 #include "ai.h"
 #include "CTime.h"
 
 const int INFTY = 9999;
 
+// Approximate value of one pawn of material in NNUE units.
+const int MATERIAL_SCALE = 208;
+
+/***************************************************************
+ * evaluate
+ *
+ * Returns the static value of the current position for the
+ * side to move. The NNUE is only run, if the position is not
+ * already in the evaluation cache.
+ ***************************************************************/
+int AI::evaluate()
+{
+    int val;
+    if (m_evalCache.find(m_board.getKey(), val))
+        return val;
+
+    val = m_board.getValue();
+    m_evalCache.insert(m_board.getKey(), val);
+    return val;
+} // end of int evaluate
+
+/***************************************************************
+ * newGame
+ ***************************************************************/
+void AI::newGame()
+{
+    m_hashTable.clear();
+    m_evalCache.clear();
+    m_killerMove = CMove();
+} // end of newGame
+
+/***************************************************************
+ * prefetch
+ *
+ * Starts loading the hash table entry and the evaluation cache
+ * slot of a child position. It is called with the key of the
+ * child (see CBoard::keyAfter) before make_move, so the memory
+ * latency overlaps with make_move, before the child looks them up.
+ ***************************************************************/
+void AI::prefetch(uint64_t key)
+{
+    m_hashTable.prefetch(key);
+    m_evalCache.prefetch(key);
+} // end of prefetch
+
+/***************************************************************
+ * lazyEvaluate
+ *
+ * Estimates the value of the current position from the material
+ * balance alone. If the estimate is so far outside the window
+ * ]lower, upper[ that the NNUE is unlikely to bring it back, the
+ * estimate (corrected by the margin) is returned in val as a bound,
+ * and the function returns true.
+ ***************************************************************/
+bool AI::lazyEvaluate(int lower, int upper, int& val)
+{
+    if (!m_lazyEval)
+        return false;
+
+    int estimate = m_board.getMaterial() * MATERIAL_SCALE;
+
+    if (estimate - m_lazyMargin >= upper)
+    {
+        val = estimate - m_lazyMargin;
+    }
+    else if (estimate + m_lazyMargin <= lower)
+    {
+        val = estimate + m_lazyMargin;
+    }
+    else
+    {
+        return false;
+    }
+
+    m_lazyCutoffs++;
+    return true;
+} // end of bool lazyEvaluate
+
+/***************************************************************
+ * timeUp
+ * Returns true, when the time for this move has been spent.
+ * A search without a time budget is not limited by time.
+ ***************************************************************/
+bool AI::timeUp() const
+{
+    if (!m_timeLimited)
+        return false;
+
+    CTime now;
+    return m_timeEnd < now;
+} // end of bool timeUp
+
+/***************************************************************
+ * checkLimits
+ * Called for every node. Sets m_stop, when the node budget or
+ * the time is used up, or stop() was called. The clock is only
+ * read every 1024 nodes, and so is the node count reported.
+ * While pondering, it waits for ponderhit().
+ * The first iteration is never stopped, so there is always a
+ * move to play.
+ ***************************************************************/
+void AI::checkLimits()
+{
+    if (m_info && (m_nodes & 1023) == 0 && m_infoTime < CTime())
+    {
+        m_info(infoStatus());
+        m_infoTime = CTime();
+        m_infoTime += INFO_INTERVAL;
+    }
+
+    if (m_pondering && m_ponderhit.load(std::memory_order_relaxed))
+    {
+        // The expected move was played. Start the clock now.
+        m_pondering = false;
+        m_timeLimited = m_timeBudget > 0;
+        m_timeEnd = CTime();
+        m_timeEnd += m_timeBudget;
+    }
+
+    if (m_stop || !m_canStop)
+        return;
+
+    if (m_abort.load(std::memory_order_relaxed))
+        m_stop = true;
+    else if (m_limits.nodes && m_nodes >= m_limits.nodes)
+        m_stop = true;
+    else if ((m_nodes & 1023) == 0 && timeUp())
+        m_stop = true;
+} // end of void checkLimits
+
+/***************************************************************
+ * extendPv
+ * The principal variation stops, where the search found a value
+ * in the hash table. This follows the best moves stored in the
+ * hash table from there, as long as they are legal.
+ ***************************************************************/
+void AI::extendPv(CMoveList& pv)
+{
+    const unsigned int MAX_PV = 16;
+
+    for (unsigned int i=0; i<pv.size(); ++i)
+    {
+        m_board.make_move(pv[i]);
+    }
+
+    while (pv.size() < MAX_PV)
+    {
+        CHashEntry hashEntry;
+        if (!m_hashTable.find(m_board.getKey(), hashEntry))
+            break;
+
+        CMove move = hashEntry.m_bestMove;
+        if (!move.Valid() || !m_board.IsMoveValid(move))
+            break;
+
+        m_board.make_move(move);
+        if (m_board.isOtherKingInCheck())
+        {
+            m_board.undo_move(move);
+            break;
+        }
+        pv.push_back(move);
+    }
+
+    for (unsigned int i=pv.size(); i-- > 0; )
+    {
+        m_board.undo_move(pv[i]);
+    }
+} // end of extendPv
+
+/***************************************************************
+ * scoreToUci
+ * The value is converted from NNUE units to centipawns. A king
+ * capture is reported as mate, counted in moves from the root.
+ ***************************************************************/
+std::string AI::scoreToUci(int val, int depth)
+{
+    if (val > 8000 || val < -8000)
+    {
+        // The king is captured at the ply after the mate.
+        int plies = std::max(1, depth - 1 - (std::abs(val) - 9000));
+        return "mate " + std::to_string(val > 0 ? (plies+1)/2 : -plies/2);
+    }
+    return "cp " + std::to_string(val*100/MATERIAL_SCALE);
+} // end of scoreToUci
+
+/***************************************************************
+ * infoStatus
+ * The part of an "info" line, that is the same for all kinds.
+ * There are no tablebases, so tbhits is always 0.
+ ***************************************************************/
+std::string AI::infoStatus() const
+{
+    unsigned long millisecs = CTimeDiff(m_timeStart).millisecs();
+    unsigned long nps = millisecs ? (m_nodes*1000)/millisecs : 0;
+
+    std::ostringstream ss;
+    ss << "nodes " << m_nodes << " nps " << nps << " hashfull " << m_hashTable.hashfull()
+        << " tbhits 0 time " << millisecs;
+    return ss.str();
+} // end of infoStatus
+
+/***************************************************************
+ * infoIteration
+ * Reports the result of an iteration, or one line of it with
+ * MultiPV.
+ ***************************************************************/
+void AI::infoIteration(int level, int val, const CMoveList& pv, unsigned int multiPv)
+{
+    if (!m_info)
+        return;
+
+    std::ostringstream ss;
+    ss << "depth " << level+1 << " seldepth " << std::max<unsigned int>(m_selDepth, level+1);
+    if (multiPv)
+        ss << " multipv " << multiPv;
+    ss << " score " << scoreToUci(val, level+1) << ' ' << infoStatus();
+    if (pv.size())
+        ss << " pv " << pv;
+
+    std::string line = ss.str();
+    while (line[line.size()-1] == ' ')
+        line.erase(line.size()-1); // The move list ends with a space
+    m_info(line);
+
+    m_infoTime = CTime();
+    m_infoTime += INFO_INTERVAL;
+} // end of infoIteration
+
+/***************************************************************
+ * infoResult
+ * Reports the result of the last iteration: Either m_pv, or all
+ * the lines with MultiPV.
+ ***************************************************************/
+void AI::infoResult(int level)
+{
+    if (m_lines.empty())
+    {
+        infoIteration(level, m_score, m_pv);
+        return;
+    }
+
+    for (unsigned int i=0; i<m_lines.size(); ++i)
+        infoIteration(level, m_lines[i].val, m_lines[i].pv, i+1);
+} // end of infoResult
+
+/***************************************************************
+ * infoCurrMove
+ * Reports the root move about to be searched. Short searches
+ * are not reported, as the GUI would not keep up.
+ ***************************************************************/
+void AI::infoCurrMove(int level, const CMove& move, unsigned int number)
+{
+    if (!m_info || CTimeDiff(m_timeStart).millisecs() < INFO_INTERVAL)
+        return;
+
+    std::ostringstream ss;
+    ss << "depth " << level+1 << " currmove " << move.ToShortString() << " currmovenumber " << number;
+    m_info(ss.str());
+} // end of infoCurrMove
+
+/***************************************************************
+ * addLine
+ * Keeps the root move in m_lines, if it is one of the m_multiPv
+ * best so far. Of equal values, the first one found stays first.
+ ***************************************************************/
+void AI::addLine(int val, const CMove& move, const CMoveList& pv)
+{
+    unsigned int ix = 0;
+    while (ix < m_lines.size() && m_lines[ix].val >= val)
+        ix++;
+    if (ix >= m_multiPv)
+        return;
+
+    t_pvLine line;
+    line.val = val;
+    line.pv = move;
+    line.pv += pv;
+    m_lines.insert(m_lines.begin() + ix, line);
+    if (m_lines.size() > m_multiPv)
+        m_lines.pop_back();
+} // end of addLine
+
 /***************************************************************
  * This is an implementation of
  * "NegaMax with Alpha Beta Pruning and Transposition Tables"
@@ -34,11 +319,17 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
     // Return a large positive value.
     if (m_board.isOtherKingInCheck()) return 9000 + level;
 
+    if (m_moveList.size() > m_selDepth)
+        m_selDepth = m_moveList.size();
+
     // First we check if we are at leaf of tree.
-    // If so, return value from NNUE.
+    // If so, return value from NNUE, unless the material
+    // balance alone decides the outcome.
     if (level == 0)
     {
-        int val = m_board.getValue();
+        int val;
+        if (!lazyEvaluate(alpha, beta, val))
+            val = evaluate();
 
         // If a capture sequence was found, store the first move in the hash table.
         // This is an optimization that improves move ordering.
@@ -59,7 +350,7 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
             }
 
             hashEntry.m_nodeTypeAndLevel.level = level;
-            hashEntry.m_hashValue              = m_hashEntry.m_hashValue;
+            hashEntry.m_hashValue              = m_board.getKey();
             hashEntry.m_searchValue            = val;
             hashEntry.m_bestMove               = pv[0];
 
@@ -72,6 +363,7 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
     }
 
     m_nodes++;
+    checkLimits();
 
     // Next, check if we have been at this position before (possibly with 
     // shallower search). This works extremely well together with iterative
@@ -79,7 +371,7 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
     // transpositions, but that is less frequent.
     // The main benefit is that it gives a good move to search first.
     CHashEntry hashEntry;
-    if (m_hashTable.find(m_hashEntry.m_hashValue, hashEntry))
+    if (m_hashTable.find(m_board.getKey(), hashEntry))
     {
 
         // Now we examine the search value stored.
@@ -161,25 +453,28 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
 
 #ifdef DEBUG_HASH
         uint32_t oldHash = m_board.calcHash();
-        CHashEntry hashCopy(m_hashEntry);
+        uint64_t oldKey = m_board.getKey();
 #endif
 
         // Do a recursive search
         m_moveList.push_back(move);
-        m_hashEntry.update(m_board, move);
+        prefetch(m_board.keyAfter(move));
         m_board.make_move(move);
 
         CMoveList pv_temp;
         int val = -search(-beta, -alpha, level-1, pv_temp);
 
         m_board.undo_move(move);
-        m_hashEntry.update(m_board, move);
         m_moveList.pop_back();
 
+        // The value is not valid, if the search was stopped.
+        if (m_stop)
+            return alpha;
+
 #ifdef DEBUG_HASH
         uint32_t newHash = m_board.calcHash();
         if (oldHash != newHash) exit(-1);
-        if (hashCopy != m_hashEntry) exit(-1);
+        if (oldKey != m_board.getKey()) exit(-1);
 #endif
 
         if (val > best_val)
@@ -206,13 +501,6 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
             // which might be outside the window.
             break;
         }
-
-        if (m_pvSearch)
-        {
-            CTime now;
-            if (m_timeEnd < now) return alpha;
-        }
-
     } // end of for
 
     // If our king was captured, check for stalemate
@@ -239,7 +527,7 @@ int AI::search(int alpha, int beta, int level, CMoveList& pv)
     }
 
     hashEntry.m_nodeTypeAndLevel.level = level;
-    hashEntry.m_hashValue              = m_hashEntry.m_hashValue;
+    hashEntry.m_hashValue              = m_board.getKey();
     hashEntry.m_searchValue            = best_val;
     hashEntry.m_bestMove               = pv[0];
 
@@ -256,11 +544,18 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
     // Return a large positive value.
     if (m_board.isOtherKingInCheck()) return -9000 - level;
 
+    if (m_moveList.size() > m_selDepth)
+        m_selDepth = m_moveList.size();
+
     // First we check if we are at leaf of tree.
-    // If so, return value from NNUE.
+    // If so, return value from NNUE, unless the material
+    // balance alone decides the outcome.
+    // Note: Here the window is ]beta, alpha[.
     if (level == 0)
     {
-        int val = m_board.getValue();
+        int val;
+        if (!lazyEvaluate(beta, alpha, val))
+            val = evaluate();
 
         // If a capture sequence was found, store the first move in the hash table.
         // This is an optimization that improves move ordering.
@@ -281,7 +576,7 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
             }
 
             hashEntry.m_nodeTypeAndLevel.level = level;
-            hashEntry.m_hashValue              = m_hashEntry.m_hashValue;
+            hashEntry.m_hashValue              = m_board.getKey();
             hashEntry.m_searchValue            = val;
             hashEntry.m_bestMove               = pv[0];
 
@@ -294,6 +589,7 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
     }
 
     m_nodes++;
+    checkLimits();
 
     // Next, check if we have been at this position before (possibly with 
     // shallower search). This works extremely well together with iterative
@@ -301,7 +597,7 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
     // transpositions, but that is less frequent.
     // The main benefit is that it gives a good move to search first.
     CHashEntry hashEntry;
-    if (m_hashTable.find(m_hashEntry.m_hashValue, hashEntry))
+    if (m_hashTable.find(m_board.getKey(), hashEntry))
     {
         // Now we examine the search value stored.
         // This value is only to be trusted, if the
@@ -382,25 +678,28 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
 
 #ifdef DEBUG_HASH
         uint32_t oldHash = m_board.calcHash();
-        CHashEntry hashCopy(m_hashEntry);
+        uint64_t oldKey = m_board.getKey();
 #endif
 
         // Do a recursive search
         m_moveList.push_back(move);
-        m_hashEntry.update(m_board, move);
+        prefetch(m_board.keyAfter(move));
         m_board.make_move(move);
 
         CMoveList pv_temp;
         int val = -search_reverse(-beta, -alpha, level-1, pv_temp);
 
         m_board.undo_move(move);
-        m_hashEntry.update(m_board, move);
         m_moveList.pop_back();
 
+        // The value is not valid, if the search was stopped.
+        if (m_stop)
+            return alpha;
+
 #ifdef DEBUG_HASH
         uint32_t newHash = m_board.calcHash();
         if (oldHash != newHash) exit(-1);
-        if (hashCopy != m_hashEntry) exit(-1);
+        if (oldKey != m_board.getKey()) exit(-1);
 #endif
 
         if (val < worst_val)
@@ -427,13 +726,6 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
             // which might be outside the window.
             break;
         }
-
-        if (m_pvSearch)
-        {
-            CTime now;
-            if (m_timeEnd < now) return alpha;
-        }
-
     } // end of for
 
     // If our king was captured, check for stalemate
@@ -460,7 +752,7 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
     }
 
     hashEntry.m_nodeTypeAndLevel.level = level;
-    hashEntry.m_hashValue              = m_hashEntry.m_hashValue;
+    hashEntry.m_hashValue              = m_board.getKey();
     hashEntry.m_searchValue            = worst_val;
     hashEntry.m_bestMove               = pv[0];
 
@@ -479,53 +771,95 @@ int AI::search_reverse(int alpha, int beta, int level, CMoveList& pv)
 CMove AI::find_best_or_worst_move(bool bestMove)
 {
     m_nodes = 0;
-    m_hashEntry.set(m_board);
     m_moveList.clear();
-
-    CTime timeStart;
-    m_timeEnd = timeStart;
-    m_timeEnd += 20000; // 20 seconds
+    m_pv.clear();
+    m_lines.clear();
+    m_depth = 0;
+
+    m_timeStart = CTime();
+    m_infoTime = m_timeStart;
+    m_infoTime += INFO_INTERVAL;
+    m_selDepth = 0;
+    m_timeBudget = m_limits.timeBudget(m_board.whiteToMove());
+    m_pondering = m_limits.ponder;
+    m_timeLimited = m_timeBudget > 0 && !m_pondering;
+    m_timeEnd = m_timeStart;
+    m_timeEnd += m_timeBudget;
+    m_canStop = false;
+    m_stop = false;
+
+    // The root move is one ply, so a search to depth d
+    // ends with the iteration at level d-1.
+    int maxLevel = m_limits.depth > 0 ? m_limits.depth - 1 : INFTY;
     CMoveList moves;
     m_board.find_legal_moves(moves);
 
     CMoveList best_moves;
 
     CMoveList pv;
-    int num_good;
+    int num_good = 0;
+    int level = 0;
 
     if(bestMove)
     {
-        int best_val, level = 0;
+        int best_val;
         while (true)
         {
             CMove best_move;
 
+            int prev_good = num_good;
             best_moves.clear();
             best_val = -INFTY;
             num_good = 0;
 
-            m_pvSearch = true;
+            std::vector<t_pvLine> prev_lines;
+            prev_lines.swap(m_lines);
 
             for (unsigned int i=0; i<moves.size(); ++i)
             {
                 // We are looking for values in the range [best_val, INFTY[, 
                 // which is the same as ]best_val-1, INFTY[
-                int alpha = best_val-1;
+                // With MultiPV, the range starts at the value of the last line,
+                // so every line gets an exact value.
+                int bound = best_val;
+                if (m_multiPv > 1)
+                    bound = m_lines.size() < m_multiPv ? -INFTY : m_lines.back().val;
+                int alpha = bound-1;
                 int beta = INFTY;
 
                 CMove move = moves[i];
+                infoCurrMove(level, move, i+1);
 
                 m_moveList.push_back(move);
-                m_hashEntry.update(m_board, move);
+                prefetch(m_board.keyAfter(move));
                 m_board.make_move(move);
 
                 CMoveList pv_temp;
                 int val = -search(-beta, -alpha, level, pv_temp);
 
                 m_board.undo_move(move);
-                m_hashEntry.update(m_board, move);
                 m_moveList.pop_back();
 
+                if (m_stop)
+                {
+                    // This move was not finished. If no move was, keep
+                    // the result of the previous iteration.
+                    if (num_good == 0)
+                    {
+                        best_moves = moves;
+                        num_good = prev_good;
+                        best_val = m_score;
+                    }
+                    if (m_lines.size() < prev_lines.size())
+                        m_lines.swap(prev_lines);
+                    break;
+                }
+
+                if (m_multiPv > 1 && val >= bound)
+                {
+                    addLine(val, move, pv_temp);
+                }
+
                 if (val > best_val)
                 {
                     num_good = 0;
@@ -541,18 +875,6 @@ CMove AI::find_best_or_worst_move(bool bestMove)
                     best_val = val;
                     best_move = move;
 
-                    CTimeDiff timeDiff(timeStart);
-
-                    // unsigned long millisecs = timeDiff.millisecs();
-
-                    // unsigned long nps = 0;
-                    // if (millisecs)
-                    //     nps = (m_nodes*1000)/millisecs;
-
-                    // std::cout << "info depth " << level << " score cp " << best_val;
-                    // std::cout << " time " << millisecs << " nodes " << m_nodes << " nps " << nps;
-                    // std::cout << " pv " << pv << std::endl;
-
                     // This is the move reordering. Good moves are searched first on next iteration.
                     best_moves.insert_front(move);
                 }
@@ -562,44 +884,55 @@ CMove AI::find_best_or_worst_move(bool bestMove)
                     best_moves.push_back(move);
                 }
 
-                m_pvSearch = false;
-                
-                CTime now;
-                if (m_timeEnd < now) break;
+                if (m_canStop && timeUp()) break;
             } // end of for
 
             moves = best_moves;
 
-            CTimeDiff timeDiff(timeStart);
-
-            // unsigned long millisecs = timeDiff.millisecs();
+            if (m_lines.size())
+            {
+                // The lines are searched first on next iteration, in their order.
+                CMoveList ordered;
+                for (unsigned int i=0; i<m_lines.size(); ++i)
+                    ordered.push_back(m_lines[i].pv[0]);
+                for (unsigned int i=0; i<moves.size(); ++i)
+                {
+                    bool inLines = false;
+                    for (unsigned int j=0; j<m_lines.size(); ++j)
+                        inLines = inLines || moves[i] == m_lines[j].pv[0];
+                    if (!inLines)
+                        ordered.push_back(moves[i]);
+                }
+                moves = ordered;
 
-            // unsigned long nps = 0;
-            // if (millisecs)
-            //     nps = (m_nodes*1000)/millisecs;
+                for (unsigned int i=0; i<m_lines.size(); ++i)
+                    extendPv(m_lines[i].pv);
+            }
 
-            // std::cout << "info depth " << level << " score cp " << best_val;
-            // std::cout << " time " << millisecs << " nodes " << m_nodes << " nps " << nps;
-            // std::cout << " pv " << pv << std::endl;
+            m_score = best_val;
+            if (!m_stop && (!m_canStop || !timeUp()))
+                m_depth = level + 1;
+            m_pv = pv;
+            extendPv(m_pv);
 
-            CTime now;
-            if (m_timeEnd < now) break;
-            level += 2;
+            if (m_stop || timeUp() || level >= maxLevel) break;
+            infoResult(level);
+            level = std::min(level + 2, maxLevel);
+            m_canStop = true;
         }
     }
     else
     {
         // std::cout << "ATTEMP TO FIND WORST MOVE\n";
-        int worst_val, level = 0;
+        int worst_val;
         while (true)
         {
             CMove best_move;
 
+            int prev_good = num_good;
             best_moves.clear();
             worst_val = INFTY;
             num_good = 0;
-
-            m_pvSearch = true;
             // std::cerr << "There are " << moves.size() << "legal moves\n";
             for (unsigned int i=0; i<moves.size(); ++i)
             {
@@ -610,9 +943,10 @@ CMove AI::find_best_or_worst_move(bool bestMove)
                 int beta = -INFTY;
 
                 CMove move = moves[i];
+                infoCurrMove(level, move, i+1);
 
                 m_moveList.push_back(move);
-                m_hashEntry.update(m_board, move);
+                prefetch(m_board.keyAfter(move));
                 m_board.make_move(move);
 
                 // std::cerr << m_board << '\n';
@@ -621,9 +955,21 @@ CMove AI::find_best_or_worst_move(bool bestMove)
                 int val = -search_reverse(-beta, -alpha, level, pv_temp);
 
                 m_board.undo_move(move);
-                m_hashEntry.update(m_board, move);
                 m_moveList.pop_back();
-                
+
+                if (m_stop)
+                {
+                    // This move was not finished. If no move was, keep
+                    // the result of the previous iteration.
+                    if (num_good == 0)
+                    {
+                        best_moves = moves;
+                        num_good = prev_good;
+                        worst_val = m_score;
+                    }
+                    break;
+                }
+
                 // std::cerr << m_board << '\n';
 
                 if (val < worst_val)
@@ -641,18 +987,6 @@ CMove AI::find_best_or_worst_move(bool bestMove)
                     worst_val = val;
                     best_move = move;
 
-                    CTimeDiff timeDiff(timeStart);
-
-                    // unsigned long millisecs = timeDiff.millisecs();
-
-                    // unsigned long nps = 0;
-                    // if (millisecs)
-                    //     nps = (m_nodes*1000)/millisecs;
-
-                    // std::cerr << "info depth " << level << " score cp " << worst_val;
-                    // std::cerr << " time " << millisecs << " nodes " << m_nodes << " nps " << nps;
-                    // std::cerr << " pv " << pv << std::endl;
-
                     // This is the move reordering. Good moves are searched first on next iteration.
                     best_moves.insert_front(move);
                 }
@@ -662,33 +996,43 @@ CMove AI::find_best_or_worst_move(bool bestMove)
                     best_moves.push_back(move);
                 }
 
-                m_pvSearch = false;
-
-                CTime now;
-                if (m_timeEnd < now) break;
+                if (m_canStop && timeUp()) break;
             } // end of for
 
             moves = best_moves;
 
-            CTimeDiff timeDiff(timeStart);
-
-            // unsigned long millisecs = timeDiff.millisecs();
+            m_score = worst_val;
+            if (!m_stop && (!m_canStop || !timeUp()))
+                m_depth = level + 1;
+            m_pv = pv;
+            extendPv(m_pv);
 
-            // unsigned long nps = 0;
-            // if (millisecs)
-            //     nps = (m_nodes*1000)/millisecs;
-
-            // std::cerr << "info depth " << level << " score cp " << worst_val;
-            // std::cerr << " time " << millisecs << " nodes " << m_nodes << " nps " << nps;
-            // std::cerr << " pv " << pv << std::endl;
-
-            CTime now;
-            if (m_timeEnd < now) break;
-            level += 2;
+            if (m_stop || timeUp() || level >= maxLevel) break;
+            infoResult(level);
+            level = std::min(level + 2, maxLevel);
+            m_canStop = true;
         }
     }
 
     CMove move;
     if(num_good) move = best_moves[rng()%num_good];
+
+    // With MultiPV, the first line is played, so the output agrees.
+    if (m_lines.size())
+    {
+        move = m_lines[0].pv[0];
+        m_score = m_lines[0].val;
+        m_pv = m_lines[0].pv;
+    }
+
+    // Of several equal moves, the PV may start with another one.
+    if (move.Valid() && (m_pv.size() == 0 || !(m_pv[0] == move)))
+    {
+        m_pv = move;
+        extendPv(m_pv);
+    }
+
+    // The last iteration is reported with the move played.
+    infoResult(level);
     return move;
 } // end of CMove find_best_or_worst_move(CBoard &board)
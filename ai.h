@@ -2,18 +2,29 @@
 #define _AI_H_
 
 #include <random>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <functional>
+#include <vector>
 
 #include "CBoard.h"
 #include "CMoveList.h"
 #include "CHashTable.h"
+#include "CEvalCache.h"
 #include "CTime.h"
+#include "CSearchLimits.h"
 
 class AI
 {
 public:
-    AI(CBoard& board, unsigned seed = 2022) : 
-        m_board(board), m_nodes(), m_hashTable(), m_hashEntry(),
-        m_moveList(), m_timeEnd(), m_pvSearch(), m_killerMove(), 
+    AI(CBoard& board, unsigned seed = 2022, unsigned hashMb = 128) : 
+        m_board(board), m_nodes(), m_hashTable(hashMb), m_evalCache(),
+        m_moveList(), m_timeEnd(), m_killerMove(), 
+        m_lazyEval(false), m_lazyMargin(), m_lazyCutoffs(),
+        m_limits(), m_timeBudget(0), m_timeLimited(false), m_canStop(false), m_stop(false), m_abort(false),
+        m_pondering(false), m_ponderhit(false), m_score(0), m_depth(0), m_pv(),
+        m_info(), m_timeStart(), m_infoTime(), m_selDepth(0), m_multiPv(1), m_lines(),
         rng(std::mt19937(seed))
         {
             m_moveList.clear();
@@ -21,18 +32,122 @@ public:
 
     CMove find_best_or_worst_move(bool bestMove = true);
 
+    // Forgets everything learned in earlier searches, i.e. clears the
+    // hash table and the evaluation cache, so the next game does not
+    // depend on the games before it.
+    void newGame();
+
+    // Restarts the random choice between moves of equal value.
+    void setSeed(unsigned seed) {rng.seed(seed);}
+
+    // Budget of the following searches.
+    void setLimits(const CSearchLimits& limits) {m_limits = limits;}
+    const CSearchLimits& getLimits() const {return m_limits;}
+
+    // Stops a running search from another thread, as soon as the first
+    // iteration is done. The flag stays set until clearStop().
+    void stop() {m_abort = true;}
+    void clearStop() {m_abort = false; m_ponderhit = false;}
+
+    // A search with limits.ponder has no time limit, until ponderhit()
+    // is called from another thread. Then the time budget starts, and
+    // the search goes on where it is.
+    void ponderhit() {m_ponderhit = true;}
+
+    // Nodes searched by the last search.
+    unsigned long getNodes() const {return m_nodes;}
+
+    // Value of the last search, for the side to move.
+    int getScore() const {return m_score;}
+
+    // Depth of the last iteration, that was searched to the end, in plies.
+    int getDepth() const {return m_depth;}
+
+    // A value as in the UCI "info score", i.e. "cp <x>" or "mate <y>".
+    // The depth of the search is needed to count the moves to mate.
+    static std::string scoreToUci(int val, int depth);
+
+    // Principal variation of the last search, starting with the move found.
+    const CMoveList& getPv() const {return m_pv;}
+
+    const CEvalCache& evalCache() const {return m_evalCache;}
+
+    // The transposition table, e.g. to save it or load it.
+    // Not while searching.
+    CHashTable& hashTable() {return m_hashTable;}
+
+    // Number of root moves, that get an exact value and a PV of their
+    // own (UCI MultiPV). They are reported as separate "info" lines.
+    // Only the best move search supports more than one.
+    void setMultiPv(unsigned int lines) {m_multiPv = std::max(1u, lines);}
+
+    // Receives the UCI "info" lines of the following searches, without
+    // the "info" itself. The search reports every iteration, and at most
+    // once per INFO_INTERVAL milliseconds the current root move and the
+    // node count. Without a receiver, nothing is reported.
+    typedef std::function<void(const std::string&)> t_info;
+    void setInfo(const t_info& info) {m_info = info;}
+    enum {INFO_INTERVAL = 1000};
+
+    // Lazy evaluation: Skip the NNUE at leaves, where the material balance
+    // is more than margin (in NNUE units) outside the search window.
+    // The default margin of about three pawns is not tuned, so lazy
+    // evaluation is off unless enabled here. Tune it with the cutoff
+    // count against the result of the experiment (main.cc -l).
+    void setLazyEval(bool enable, int margin = 600) {m_lazyEval = enable; m_lazyMargin = margin;}
+    unsigned long lazyCutoffs() const {return m_lazyCutoffs;}
+
 private:
+    // A root move with its exact value, for MultiPV
+    struct t_pvLine
+    {
+        t_pvLine() : val(), pv() {}
+
+        int       val;
+        CMoveList pv;
+    };
+
+    int evaluate();
+    void prefetch(uint64_t key);
+    bool timeUp() const;
+    void checkLimits();
+    void extendPv(CMoveList& pv);
+    std::string infoStatus() const;
+    void infoIteration(int level, int val, const CMoveList& pv, unsigned int multiPv = 0);
+    void infoCurrMove(int level, const CMove& move, unsigned int number);
+    void infoResult(int level);
+    void addLine(int val, const CMove& move, const CMoveList& pv);
+    bool lazyEvaluate(int lower, int upper, int& val);
     int search(int alpha, int beta, int level, CMoveList& pv);
     int search_reverse(int alpha, int beta, int level, CMoveList& pv);
 
     CBoard&         m_board;
     unsigned long   m_nodes;
     CHashTable      m_hashTable;
-    CHashEntry      m_hashEntry;
+    CEvalCache      m_evalCache;
     CMoveList       m_moveList;
     CTime           m_timeEnd;
-    bool            m_pvSearch;
     CMove           m_killerMove;
+    bool            m_lazyEval;
+    int             m_lazyMargin;
+    unsigned long   m_lazyCutoffs;
+    CSearchLimits   m_limits;
+    int             m_timeBudget;
+    bool            m_timeLimited;
+    bool            m_canStop;      // False until the first iteration is done
+    bool            m_stop;         // A limit was reached inside the search
+    std::atomic<bool> m_abort;      // Set by stop()
+    bool            m_pondering;    // No time limit until ponderhit()
+    std::atomic<bool> m_ponderhit;  // Set by ponderhit()
+    int             m_score;
+    int             m_depth;
+    CMoveList       m_pv;
+    t_info          m_info;
+    CTime           m_timeStart;
+    CTime           m_infoTime;     // When to report the node count again
+    unsigned int    m_selDepth;     // Longest line searched, in plies
+    unsigned int    m_multiPv;
+    std::vector<t_pvLine> m_lines;  // The best root moves of the last iteration, best first
 
     std::mt19937 rng;
 }; // end of class AI
@@ -0,0 +1,251 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+
+#include "CBoard.h"
+#include "nnue.h"
+
+// NNUE throughput benchmark.
+//
+// Replays a corpus of positions through the NNUE and reports the number of
+// evaluations per second for:
+// - full refresh  : the accumulator is computed from scratch.
+// - incremental   : the accumulator is updated from the parent position,
+//                   once for every legal move in the position.
+// - forward pass  : the accumulator is already computed, so only the
+//                   dense layers are run.
+//
+// nnue.cc is compiled once for each SIMD code path, see "make bench-nnue".
+
+typedef std::chrono::steady_clock t_clock;
+
+/***************************************************************
+ * t_input
+ * The arguments of one evaluation.
+ ***************************************************************/
+struct t_input
+{
+    int          player;
+    int          pieces[33];
+    int          squares[33];
+    DirtyPiece   dirtyPiece;    // The move from the parent, if any
+    unsigned int parent;        // Index of the parent position, if any
+};
+
+static void set_input(const CBoard& board, t_input& input)
+{
+    input.player = !board.whiteToMove();
+    board.getPieces(input.pieces, input.squares);
+    input.dirtyPiece.dirtyNum = 0;
+    input.parent = 0;
+} // end of set_input
+
+/***************************************************************
+ * set_dirty_piece
+ * Describes the pieces changed by the move, as needed by
+ * nnue_evaluate_incremental.
+ ***************************************************************/
+static void set_dirty_piece(const CMove& move, DirtyPiece& dp)
+{
+    int piece = move.GetPiece();
+    int from  = move.From();
+    int to    = move.To();
+
+    dp.dirtyNum = 1;
+    dp.pc[0]    = CBoard::nnuePiece(piece);
+    dp.from[0]  = CBoard::nnueSquare(from);
+    dp.to[0]    = CBoard::nnueSquare(to);
+
+    if (move.is_it_a_capture())
+    {
+        dp.pc[dp.dirtyNum]   = CBoard::nnuePiece(move.GetCaptured());
+        dp.from[dp.dirtyNum] = CBoard::nnueSquare(to);
+        dp.to[dp.dirtyNum]   = 64;
+        dp.dirtyNum++;
+    }
+    else if ((piece == WP || piece == BP) && (to - from) % 10 != 0)
+    {
+        // En-passant capture
+        int sq = piece == WP ? to - 10 : to + 10;
+        dp.pc[dp.dirtyNum]   = CBoard::nnuePiece(-piece);
+        dp.from[dp.dirtyNum] = CBoard::nnueSquare(sq);
+        dp.to[dp.dirtyNum]   = 64;
+        dp.dirtyNum++;
+    }
+
+    if (move.GetPromoted() != EM)
+    {
+        dp.to[0] = 64;
+        dp.pc[dp.dirtyNum]   = CBoard::nnuePiece(move.GetPromoted());
+        dp.from[dp.dirtyNum] = 64;
+        dp.to[dp.dirtyNum]   = CBoard::nnueSquare(to);
+        dp.dirtyNum++;
+    }
+
+    if ((piece == WK || piece == BK) && (to - from == 2 || from - to == 2))
+    {
+        // Castling. Move the rook too.
+        int rook = piece == WK ? WR : BR;
+        dp.pc[dp.dirtyNum]   = CBoard::nnuePiece(rook);
+        dp.from[dp.dirtyNum] = CBoard::nnueSquare(to > from ? from + 3 : from - 4);
+        dp.to[dp.dirtyNum]   = CBoard::nnueSquare(to > from ? from + 1 : from - 1);
+        dp.dirtyNum++;
+    }
+} // end of set_dirty_piece
+
+/***************************************************************
+ * report
+ ***************************************************************/
+static void report(const char *name, unsigned long evals, t_clock::duration elapsed)
+{
+    double secs = std::chrono::duration<double>(elapsed).count();
+    std::cout << nnue_arch() << " " << name << " : " << evals << " evals in "
+        << secs << " s, " << (unsigned long) (secs > 0 ? evals / secs : 0) << " evals/s" << std::endl;
+} // end of report
+
+/***************************************************************
+ * main
+ ***************************************************************/
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <nnue file> <epd file> [repetitions]" << std::endl;
+        return 1;
+    }
+
+    if (!nnue_init(argv[1]))
+        return 1;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 10;
+
+    // Load the corpus. Each position is stored with all its legal moves.
+    std::vector<CBoard> boards;
+    std::vector<CMoveList> moveLists;
+    {
+        std::ifstream epdFile(argv[2]);
+        if (!epdFile.is_open())
+        {
+            std::cout << "Could not open file: " << argv[2] << std::endl;
+            return 1;
+        }
+
+        std::string line;
+        while (getline(epdFile, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            CBoard board;
+            if (board.read_from_fen(line.c_str()))
+                continue;
+
+            CMoveList moves;
+            CMoveList legal;
+            board.find_legal_moves(moves);
+            for (unsigned int i=0; i<moves.size(); ++i)
+            {
+                board.make_move(moves[i]);
+                if (!board.isOtherKingInCheck())
+                    legal.push_back(moves[i]);
+                board.undo_move(moves[i]);
+            }
+
+            boards.push_back(board);
+            moveLists.push_back(legal);
+        }
+    }
+    std::cout << "Loaded " << boards.size() << " positions from " << argv[2] << std::endl;
+
+    // The input of every evaluation is prepared first, so the
+    // three modes only time the evaluations themselves.
+    std::vector<t_input> positions(boards.size());
+    std::vector<t_input> children;
+    for (unsigned int i=0; i<boards.size(); ++i)
+    {
+        CBoard& board = boards[i];
+        CMoveList& moves = moveLists[i];
+        set_input(board, positions[i]);
+        for (unsigned int m=0; m<moves.size(); ++m)
+        {
+            t_input child;
+            board.make_move(moves[m]);
+            set_input(board, child);
+            set_dirty_piece(moves[m], child.dirtyPiece);
+            child.parent = i;
+            children.push_back(child);
+            board.undo_move(moves[m]);
+        }
+    }
+
+    // The accumulators of the corpus positions. They are the parents
+    // of the incremental updates, and with them the forward pass only
+    // runs the dense layers.
+    std::vector<NNUEdata> computed(positions.size());
+    for (unsigned int i=0; i<positions.size(); ++i)
+    {
+        NNUEdata *nnue[3] = {&computed[i], 0, 0};
+        computed[i].accumulator.computedAccumulation = 0;
+        nnue_evaluate_incremental(positions[i].player, positions[i].pieces, positions[i].squares, nnue);
+    }
+
+    long checksum = 0;
+
+    // Full refresh
+    {
+        unsigned long evals = 0;
+        t_clock::time_point start = t_clock::now();
+        for (int r=0; r<repetitions; ++r)
+        {
+            for (unsigned int i=0; i<positions.size(); ++i)
+            {
+                checksum += nnue_evaluate(positions[i].player, positions[i].pieces, positions[i].squares);
+                evals++;
+            }
+        }
+        report("full refresh", evals, t_clock::now() - start);
+    }
+
+    // Incremental update from the parent accumulator
+    {
+        unsigned long evals = 0;
+        NNUEdata *data = new NNUEdata;
+        t_clock::time_point start = t_clock::now();
+        for (int r=0; r<repetitions; ++r)
+        {
+            for (unsigned int c=0; c<children.size(); ++c)
+            {
+                t_input& child = children[c];
+                data->dirtyPiece = child.dirtyPiece;
+                data->accumulator.computedAccumulation = 0;
+                NNUEdata *nnue[3] = {data, &computed[child.parent], 0};
+                checksum += nnue_evaluate_incremental(child.player, child.pieces, child.squares, nnue);
+                evals++;
+            }
+        }
+        report("incremental ", evals, t_clock::now() - start);
+        delete data;
+    }
+
+    // Dense layers only. The accumulators are already computed.
+    {
+        unsigned long evals = 0;
+        t_clock::time_point start = t_clock::now();
+        for (int r=0; r<repetitions; ++r)
+        {
+            for (unsigned int i=0; i<positions.size(); ++i)
+            {
+                NNUEdata *nnue[3] = {&computed[i], 0, 0};
+                checksum += nnue_evaluate_incremental(positions[i].player, positions[i].pieces, positions[i].squares, nnue);
+                evals++;
+            }
+        }
+        report("forward pass", evals, t_clock::now() - start);
+    }
+
+    std::cout << "Checksum " << checksum << std::endl;
+    return 0;
+} // end of int main
+
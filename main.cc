@@ -1,107 +1,167 @@
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
-#include <string.h>
-#include <chrono>
-#include <random>
-#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
 
-#include "CBoard.h"
-#include "ai.h"
-#include "parallel_for.h"
+#include "match.h"
+#include "CSelfPlay.h"
 #include "nnue.h"
+#include "parallel_for.h"
 
 // Experiment script
 
 const int n = 6;
 
-void match(
-    int player,
-    double strength, 
-    bool isPlayingWhite, 
-    int (&arr)[n][3],
-    bool againsStockFish)
+int main(int argc, char **argv)
 {
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-    std::default_random_engine generator (seed);
-    std::uniform_real_distribution<double> distribution(0.0,1.0);
-    CBoard board;
-    board.newGame();
-    std::cerr << "Init value:\n" << board.getValue() << '\n';
-    AI gm = AI(board), levy = AI(board);
-    while (true)
+    int n_games = 20;
+    unsigned int threads = 0;
+    unsigned int hashMb = 128;
+    int lazyMargin = 0;
+    unsigned int seed = CMatchRunner::DEFAULT_SEED;
+    CSearchLimits limits;
+    t_adjudication adj;
+    const char *openingFile = NULL;
+    const char *engineCommand = NULL;
+    const char *selfPlayFile = NULL;
+    int randomPlies = 8;
+    bool useSprt = false;
+    double elo0 = 0, elo1 = 50, alpha = 0.05, beta = 0.05;
+
+    int c;
+    while ((c = getopt(argc, argv, "n:j:H:l:N:d:m:c:S:R:D:M:o:e:G:r:s:h")) != -1)
     {
-        CMove best_move;
-        if (isPlayingWhite && board.whiteToMove())
-        {
-            best_move = levy.find_best_or_worst_move(distribution(generator) <= strength);
-        }
-        else
-        {
-            best_move = gm.find_best_or_worst_move(againsStockFish);
-        }
-        if (!best_move.Valid())
+        switch (c)
         {
-            // Oops. No legal move was found
-            bool check = board.isOtherKingInCheck();
-            if (check) arr[player][board.whiteToMove() == isPlayingWhite ? 0 : 2]++;
-            else arr[player][1]++;
-            break;
-        }
-        board.make_move(best_move);
-        std::cerr << best_move.ToLongString() << ' ' << board.getValue() << '\n';
+            case 'n' : n_games = atoi(optarg); break;
+            case 'j' : threads = atoi(optarg); break;
+            case 'H' : hashMb = atoi(optarg); break;
+            case 'l' : lazyMargin = atoi(optarg); break;
+            case 's' : seed = strtoul(optarg, NULL, 10); break;
+            case 'N' : limits.nodes = strtoul(optarg, NULL, 10); break;
+            case 'd' : limits.depth = atoi(optarg); break;
+            case 'm' : limits.movetime = atoi(optarg); break;
+            case 'R' : sscanf(optarg, "%d,%d", &adj.resignScore, &adj.resignPlies); break;
+            case 'D' : sscanf(optarg, "%d,%d,%d", &adj.drawScore, &adj.drawPlies, &adj.drawMinPly); break;
+            case 'M' : adj.maxPlies = atoi(optarg); break;
+            case 'o' : openingFile = optarg; break;
+            case 'e' : engineCommand = optarg; break;
+            case 'G' : selfPlayFile = optarg; break;
+            case 'r' : randomPlies = atoi(optarg); break;
+            case 'c' : sscanf(optarg, "%d+%d", &limits.wtime, &limits.winc);
+                       limits.btime = limits.wtime;
+                       limits.binc = limits.winc;
+                       break;
+            case 'S' : useSprt = sscanf(optarg, "%lf,%lf,%lf,%lf", &elo0, &elo1, &alpha, &beta) >= 2; break;
 
-        // 50-move rule
-        if(board.fiftyMoveDraw())
-        {
-            //std::cerr << "Evoke draw by 50-move rule\n";
-            arr[player][1]++;
-            break;
+            case 'h' :
+            default : {
+                          std::cout << "Options:" << std::endl;
+                          std::cout << "-n <n>  : Number of games per strength level and opponent (default 20)" << std::endl;
+                          std::cout << "-j <n>  : Number of games to play in parallel (default is all cores)" << std::endl;
+                          std::cout << "-H <mb> : Size of hash table per engine (default 128)" << std::endl;
+                          std::cout << "-l <n>  : Enable lazy evaluation with this margin (NNUE units, untuned)" << std::endl;
+                          std::cout << "-s <n>  : Seed of the random numbers of the experiment (default "
+                                    << CMatchRunner::DEFAULT_SEED << ")" << std::endl;
+                          std::cout << "-N <n>  : Search n nodes per move" << std::endl;
+                          std::cout << "-d <n>  : Search to depth n per move" << std::endl;
+                          std::cout << "-m <ms> : Search for ms milliseconds per move (default 20000,\n"
+                                       "          unless -N or -d is given)" << std::endl;
+                          std::cout << "-R <score>,<plies>\n"
+                                       "        : Adjudicate a win, when the NNUE score is at least score\n"
+                                       "          for the same side for plies consecutive plies" << std::endl;
+                          std::cout << "-D <score>,<plies>[,<minply>]\n"
+                                       "        : Adjudicate a draw, when the NNUE score is within +/- score\n"
+                                       "          for plies consecutive plies, from ply minply on" << std::endl;
+                          std::cout << "-M <n>  : Adjudicate a draw after n plies" << std::endl;
+                          std::cout << "-o <file> : Start the games from the positions in this EPD/FEN file.\n"
+                                       "          Each position is played twice, with colours swapped" << std::endl;
+                          std::cout << "-c <ms>+<inc> : Play with a clock of ms milliseconds plus an increment per move" << std::endl;
+                          std::cout << "-e <command> : Play the games against StockFish against this UCI engine,\n"
+                                       "          e.g. \"stockfish\" or \"./mchess-uci.exe\"" << std::endl;
+                          std::cout << "-G <file> : Instead of the experiment, play n games of self-play,\n"
+                                       "          and write the positions as training data to the file" << std::endl;
+                          std::cout << "-r <n>  : Random plies at the start of each self-play game (default 8)" << std::endl;
+                          std::cout << "-S <elo0>,<elo1>[,<alpha>,<beta>]\n"
+                                       "        : Stop each pairing, when an SPRT of elo0 against elo1 is decided.\n"
+                                       "          -n is then the maximum number of games (default alpha = beta = 0.05)" << std::endl;
+                          std::cout << "-h      : Show this message" << std::endl;
+                          exit(1);
+                      }
         }
     }
-}
 
-int main()
-{
     nnue_init("nn-04cf2b4ed1da.nnue");
 
+    COpenings openings;
+    if (openingFile && !openings.load(openingFile))
+    {
+        std::cout << "Could not read openings from file: " << openingFile << std::endl;
+        return 1;
+    }
+
+    if (threads)
+        pl::ThreadPool::instance().resize(threads);
+
+    if (selfPlayFile)
+    {
+        setMatchLog(false);
+
+        CSelfPlay selfPlay(threads, hashMb);
+        selfPlay.setLimits(limits);
+        selfPlay.setAdjudication(adj);
+        selfPlay.setOpenings(&openings);
+        selfPlay.setRandomPlies(randomPlies);
+        if (!selfPlay.run(selfPlayFile, n_games))
+        {
+            std::cout << "Could not write file: " << selfPlayFile << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     freopen("result.csv", "w", stdout);
-    int n_games = 20, StinkFish[n][3], StockFish[n][3];
-    memset(StinkFish, 0, sizeof(StinkFish));
-    memset(StockFish, 0, sizeof(StockFish));
-    
-    // pl::async_par_for(0, n, [&](int i)
-    // {
-    //     pl::async_par_for(0, n_games, [&](int j)
-    //     {
-    //         std::cerr << "Against StinkFish " << i << ' ' << j << '\n';
-    //         match(i, (double) i/(n-1), j&1, StinkFish, false);
-    //     });
-
-    //     pl::async_par_for(0, n_games, [&](int j)
-    //     {
-    //         std::cerr << "Against StockFish " << i << ' ' << j << '\n';
-    //         match(i, (double) i/(n-1), j&1, StockFish, true);
-    //     });
-    // });
+
+    CMatchRunner runner(n, threads, hashMb);
+    runner.setLazyEval(lazyMargin);
+    runner.setSeed(seed);
+    runner.setLimits(limits);
+    runner.setAdjudication(adj);
+    runner.setOpenings(&openings);
+    if (engineCommand)
+        runner.setEngine(engineCommand);
+    if (useSprt)
+        runner.setSprt(CSprt(elo0, elo1, alpha, beta));
 
     for (int i = 0; i < n; i++)
     {
         double strength = (double) i/(n-1);
+        // Games 2k and 2k+1 play the same opening, with colours swapped.
         for (int j = 0; j < n_games; j++)
         {
-            std::cerr << "Against StinkFish " << i << ' ' << j << '\n';
-            match(i, strength, j&1, StinkFish, false);
+            int opening = openings.size() ? (j/2) % openings.size() : -1;
+            t_game game = {i, strength, (j&1) != 0, false, opening};
+            runner.add(game);
         }
         for (int j = 0; j < n_games; j++)
         {
-            std::cerr << "Against StockFish " << i << ' ' << j << '\n';
-            match(i, strength, j&1, StockFish, true);
+            int opening = openings.size() ? (j/2) % openings.size() : -1;
+            t_game game = {i, strength, (j&1) != 0, true, opening};
+            runner.add(game);
         }
     }
 
+    runner.run();
+
     for (int i = 0; i < n; i++)
     {
-        printf("%d,%d,%d,%d,%d,%d\n", StinkFish[i][0], StinkFish[i][1], StinkFish[i][2], StockFish[i][0], StockFish[i][1], StockFish[i][2]);
+        printf("%d,%d,%d,%d,%d,%d",
+                runner.result(false, i, resultLoss), runner.result(false, i, resultDraw), runner.result(false, i, resultWin),
+                runner.result(true,  i, resultLoss), runner.result(true,  i, resultDraw), runner.result(true,  i, resultWin));
+        // SPRT decisions: -1 = H0, 0 = undecided, 1 = H1
+        if (useSprt)
+            printf(",%d,%d", runner.decision(false, i), runner.decision(true, i));
+        printf("\n");
     }
-}
\ No newline at end of file
+}
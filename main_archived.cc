@@ -1,13 +1,26 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <unistd.h>
 #include <string.h>
 #include <chrono>
 #include <random>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 #include "CBoard.h"
 #include "ai.h"
 #include "nnue.h"
+#include "CScorer.h"
+#include "perft.h"
+#include "pack.h"
+#include "CLineFile.h"
+#include "CUci.h"
+#include "CServer.h"
+#include "CAnalysisCache.h"
+#include "parallel_for.h"
 
 #ifdef ENABLE_TRACE
 std::ostream *gpTrace = 0;
@@ -20,13 +33,9 @@ std::ostream *gpTrace = 0;
  ***************************************************************/
 int main(int argc, char **argv)
 {
-    nnue_init("nn-04cf2b4ed1da.nnue");
-
-    bool uciMode = false;
     //srand(time(0)); // Seed the random number generator
     
     CBoard board;
-    AI ai[2] = {AI(board), AI(board)};
     double strength = 1.0;
     /*
     std::cout << "Input strength: ";
@@ -42,22 +51,41 @@ int main(int argc, char **argv)
     std::bernoulli_distribution distribution(strength);
 
     int c;
-
-    while ((c = getopt(argc, argv, "t:f:s:p:h")) != -1)
+    const char *scoreFile = NULL;
+    const char *perftFile = NULL;
+    const char *packFile = NULL;
+    const char *unpackFile = NULL;
+    const char *serverAddress = NULL;
+    const char *cacheFile = NULL;
+    unsigned int recordSize = sizeof(CPackedBoard);
+    int scoreDepth = 0;
+    unsigned int threads = 0;
+
+    while ((c = getopt(argc, argv, "t:f:s:p:e:d:j:P:U:b:S:c:h")) != -1)
     {
         switch (c)
         {
+            case 'e' : scoreFile = optarg; break;
+            case 'p' : perftFile = optarg; break;
+            case 'd' : scoreDepth = atoi(optarg); break;
+            case 'j' : threads = atoi(optarg); break;
+            case 'P' : packFile = optarg; break;
+            case 'U' : unpackFile = optarg; break;
+            case 'b' : recordSize = atoi(optarg); break;
+            case 'S' : serverAddress = optarg; break;
+            case 'c' : cacheFile = optarg; break;
+
             case 't' : std::cout << "Trace not supported" << std::endl; return 1;
 
             case 'f' : {
-                           std::ifstream fenFile;
-                           fenFile.open(optarg);
-                           if (!fenFile.is_open())
+                           CLineFile fenFile;
+                           if (!fenFile.open(optarg))
                            {
                                std::cout << "Could not open file: " << optarg << std::endl;
                            }
                            std::string fen;
-                           getline(fenFile, fen);
+                           CLineFile::forEachLine(CLineFile::head(fenFile.all(), 0),
+                                   [&fen](const char *line, size_t length) { fen.assign(line, length); });
                            if (board.read_from_fen(fen.c_str()))
                            {
                                std::cout << "Error reading from FEN" << std::endl;
@@ -72,186 +100,105 @@ int main(int argc, char **argv)
                           std::cout << "-s <file> : Run search on test suite" << std::endl;
                           std::cout << "-p <file> : Run performance test on test suite" << std::endl;
                           std::cout << "-f <file> : Read initial position from FEN file" << std::endl;
+                          std::cout << "-e <file> : Score all positions in EPD/FEN file, output to stdout" << std::endl;
+                          std::cout << "-d <n>    : Score with a search to depth n (default is NNUE only),\n"
+                                       "            or the maximum perft depth" << std::endl;
+                          std::cout << "-j <n>    : Number of threads (default is all cores)" << std::endl;
+                          std::cout << "-S <addr> : Serve analysis requests on a Unix socket (path) or TCP [host:]port" << std::endl;
+                          std::cout << "-c <file> : Analysis cache for -S and -e, created if it does not exist" << std::endl;
+                          std::cout << "-P <file> : Pack all positions in EPD/FEN file, output to stdout" << std::endl;
+                          std::cout << "-U <file> : Unpack all positions in packed file to FEN, output to stdout" << std::endl;
+                          std::cout << "-b <n>    : Size of the records to unpack (default 32, 36 for training data)" << std::endl;
                           std::cout << "-h        : Show this message" << std::endl;
                           exit(1);
                       }
         }
     }
 
-    while (true) // Repeat forever
+    if (threads)
+        pl::ThreadPool::instance().resize(threads);
+
+    if (packFile)
     {
-        if (!uciMode)
+        CLineFile epdFile;
+        if (!epdFile.open(packFile))
         {
-            std::cout << board;
-            std::cout << "Input command : ";
+            std::cout << "Could not open file: " << packFile << std::endl;
+            return 1;
         }
-        std::string str;
-        getline(std::cin, str);
-        if (!uciMode)
-        {
-            std::cout << std::endl;
-        }
-        if (std::cin.eof() || str == "quit")
-        {
-            exit(1);
-        }
-        if (str == "uci")
+#ifdef _WIN32
+        // In text mode every 0x0A byte would become "\r\n"
+        std::cout.flush();
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        unsigned long count = pack_positions(epdFile, std::cout);
+        std::cerr << count << " positions packed" << std::endl;
+        return std::cout ? 0 : 1;
+    }
+
+    if (unpackFile)
+    {
+        std::ifstream binFile(unpackFile, std::ios::binary);
+        if (!binFile.is_open())
         {
-#define DEF_STR(x) #x
-#define DEF_XSTR(x) DEF_STR(x)
-            std::cout << "id name " << DEF_XSTR(NAME) << std::endl;
-            std::cout << "id author MJ" << std::endl;
-            std::cout << "uciok" << std::endl;
-            uciMode = true;
+            std::cout << "Could not open file: " << unpackFile << std::endl;
+            return 1;
         }
-        if (str == "isready")
+        unsigned long count = unpack_positions(binFile, std::cout, recordSize);
+        std::cerr << count << " positions unpacked" << std::endl;
+        return std::cout ? 0 : 1;
+    }
+
+    // The conversions above do not need the NNUE.
+    bool nnueLoaded = nnue_init("nn-04cf2b4ed1da.nnue");
+
+    CAnalysisCache cache;
+    if (cacheFile && !cache.open(cacheFile))
+    {
+        std::cout << "Could not open analysis cache: " << cacheFile << std::endl;
+        return 1;
+    }
+
+    if (perftFile)
+    {
+        CLineFile epdFile;
+        if (!epdFile.open(perftFile))
         {
-            std::cout << "readyok" << std::endl;
+            std::cout << "Could not open file: " << perftFile << std::endl;
+            return 1;
         }
-        if (str == "ucinewgame")
+        return perft_suite(epdFile, std::cout, scoreDepth) ? 0 : 1;
+    }
+
+    if (scoreFile)
+    {
+        CLineFile epdFile;
+        if (!epdFile.open(scoreFile))
         {
-            board.newGame();
+            std::cout << "Could not open file: " << scoreFile << std::endl;
+            return 1;
         }
-        if (str.compare(0, 9, "position ") == 0)
+        if (!nnueLoaded)
         {
-            if (str.compare(9, 9, "startpos ") == 0)
-            {
-                board.newGame();
-            } else if (str.compare(9, 4, "fen ") == 0)
-            {
-                if (board.read_from_fen(str.substr(13).c_str()))
-                {
-                    std::cout << "Error reading from FEN" << std::endl;
-                }
-            }
-
-            size_t pos = str.find("moves ");
-            if (pos != std::string::npos)
-            {
-                pos += 6;
-                CMove move;
-                const char *p = str.c_str()+pos;
-                std::cout << p << std::endl;
-                while ((p = move.FromString(p)) != NULL)
-                {
-                    if (!board.IsMoveValid(move))
-                    {
-                        std::cout << "Invalid move " << move << std::endl;
-                        std::cout << board << std::endl;
-                        std::cout << p << std::endl;
-                        break;
-                    }
-                    board.make_move(move);
-                }
-            }
+            std::cerr << "Can not score positions without the NNUE" << std::endl;
+            return 1;
         }
+        CScorer scorer(scoreDepth, threads);
+        scorer.setCache(&cache);
+        bool ok = scorer.run(epdFile, std::cout);
+        if (cacheFile)
+            std::cerr << "Analysis cache hits/misses: " << cache.hits() << '/' << cache.misses() << std::endl;
+        return ok ? 0 : 1;
+    }
 
-        if (str.compare(0, 5, "move ") == 0)
-        {
-            CMove move;
-
-            if (move.FromString(str.c_str()+5) == NULL)
-            {
-                std::cout << "Try again. Use long notation, e.g. e2e4" << std::endl;
-                continue; // Go back to beginning
-            }
-
-            if (board.IsMoveValid(move))
-            {
-                board.make_move(move);
-                bool check = board.isOtherKingInCheck();
-                board.undo_move(move);
-                if (check)
-                {
-                    std::cout << "You are in CHECK. Play another move." << std::endl;
-                    continue;
-                }
-
-                std::cout << "You move : " << move << std::endl;
-                board.make_move(move);
-            }
-        } // end of "move "
-
-        if (str.compare(0, 2, "go") == 0)
-        {
-            const char *p = str.c_str() + 2;
-            while (*p == ' ')
-                ++p;
-
-            int wtime_ms = 300000;
-            int btime_ms = 300000;
-            int movesToGo = 40;
-
-            while (*p)
-            {
-                if (strncmp(p, "wtime", 5) == 0)
-                {
-                    p += 5;
-                    while (*p == ' ')
-                        ++p;
-                    wtime_ms = strtol(p, (char **)&p, 10);
-                }
-                else if (strncmp(p, "btime", 5) == 0)
-                {
-                    p += 5;
-                    while (*p == ' ')
-                        ++p;
-                    btime_ms = strtol(p, (char **)&p, 10);
-                }
-                else if (strncmp(p, "movestogo", 9) == 0)
-                {
-                    p += 9;
-                    while (*p == ' ')
-                        ++p;
-                    movesToGo = strtol(p, (char **)&p, 10);
-                }
-                else /* Skip rest of line */
-                    break;
-
-                while (*p == ' ')
-                    ++p;
-            } // end of while
-
-            CMove best_move = ai[0].find_best_or_worst_move(true);//(wtime_ms, btime_ms, movesToGo);
-
-            if (!best_move.Valid())
-            {
-                // Oops. No legal move was found
-                bool check = board.isOtherKingInCheck() || board.isKingInCheck();
-                if (check)
-                {
-                    std::cout << "I am checkmated. YOU WON!" << std::endl;
-                }
-                else
-                {
-                    std::cout << "I have no legal moves. It is a STALE MATE!" << std::endl;
-                }
-                break;
-            }
-
-            std::cout << "bestmove " << best_move << std::endl;
-
-            board.make_move(best_move);
-        } // end of "go"
-
-        if (str == "show")
-        {
-            CMoveList moves;
-            board.find_legal_moves(moves);
-            for (unsigned int i=0; i<moves.size(); ++i)
-            {
-                const CMove & move = moves[i];
-                board.make_move(move);
-                if (!board.isOtherKingInCheck())
-                {
-                    std::cout << move << " ";
-                }
-                board.undo_move(move);
-            }
-            std::cout << std::endl;
-        } // end of "show"
-    } // end of while (true)
+    if (serverAddress)
+    {
+        CServer server(threads);
+        server.setCache(&cache);
+        return server.run(serverAddress) ? 0 : 1;
+    }
 
-    return 0;
+    CUci uci(board, seed);
+    return uci.run(std::cin, std::cout);
 } // end of int main()
 
@@ -0,0 +1,333 @@
+#include <iostream>
+#include <sstream>
+
+#include "match.h"
+#include "parallel_for.h"
+
+static std::atomic<bool> gMatchLog(true);
+
+void setMatchLog(bool enable)
+{
+    gMatchLog = enable;
+}
+
+
+/***************************************************************
+ * logResult
+ ***************************************************************/
+static e_result logResult(const t_game& game, const CReferee& referee, const AI& levy)
+{
+    e_result result = resultDraw;
+    if (referee.winner())
+        result = (referee.winner() > 0) == game.isPlayingWhite ? resultWin : resultLoss;
+
+    std::ostringstream log;
+    log << "Game ended by " << referee.reason() << '\n';
+    log << "Eval cache hits/misses: "
+        << levy.evalCache().hits() << '/' << levy.evalCache().misses() << '\n';
+    if (gMatchLog) std::cerr << log.str();
+
+    return result;
+} // end of logResult
+
+
+/***************************************************************
+ * match
+ *
+ * Plays one game between the player (levy), who chooses the best
+ * move with probability strength and otherwise the worst move,
+ * and the opponent (gm), who always chooses the best or always
+ * the worst move.
+ * The game starts from the position on the board, and the referee
+ * decides when it is over.
+ * The board and engines are reused from game to game, but the
+ * engines start each game with empty hash tables, as new ones
+ * would, so a result does not depend on the games played before
+ * by the same worker.
+ ***************************************************************/
+e_result match(CBoard& board, AI& levy, AI& gm, const t_game& game,
+        CReferee& referee, std::default_random_engine& generator,
+        std::vector<t_trainingRecord> *records)
+{
+    size_t firstRecord = records ? records->size() : 0;
+
+    std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+    std::ostringstream log;
+    if (gMatchLog)
+    {
+        log << "Init value:\n" << board.getValue() << '\n';
+        std::cerr << log.str();
+    }
+
+    levy.newGame();
+    gm.newGame();
+    referee.newGame(board);
+    while (!referee.beforeMove(board))
+    {
+        referee.startClock();
+        CMove best_move;
+        if (game.isPlayingWhite == board.whiteToMove())
+        {
+            levy.setLimits(referee.limits());
+            best_move = levy.find_best_or_worst_move(distribution(generator) <= game.strength);
+        }
+        else
+        {
+            gm.setLimits(referee.limits());
+            best_move = gm.find_best_or_worst_move(game.againstStockFish);
+        }
+
+        if (records)
+        {
+            const AI& ai = game.isPlayingWhite == board.whiteToMove() ? levy : gm;
+            t_trainingRecord record;
+            board.pack(record.position);
+            record.score = ai.getScore();
+            record.result = 0;
+            record.reserved = 0;
+            records->push_back(record);
+        }
+
+        board.make_move(best_move);
+
+        int value = board.getValue();
+        log.str("");
+        log << best_move.ToLongString() << ' ' << value << '\n';
+        if (gMatchLog) std::cerr << log.str();
+
+        if (referee.afterMove(board, best_move, value))
+            break;
+    }
+
+    if (records)
+    {
+        for (size_t i = firstRecord; i < records->size(); ++i)
+        {
+            t_trainingRecord& record = (*records)[i];
+            bool whiteToMove = (record.position.state & 1) == 0;
+            record.result = whiteToMove ? referee.winner() : -referee.winner();
+        }
+    }
+
+    return logResult(game, referee, levy);
+} // end of match
+
+
+/***************************************************************
+ * match
+ *
+ * Plays one game between the player (levy) and an external
+ * engine. The engine gets the start position and all moves of
+ * the game for every move, as in a GUI.
+ * The engine must be ready for a new game. If it fails during
+ * the game, it loses the game, and is stopped, so the caller
+ * starts it again for the next one.
+ ***************************************************************/
+e_result match(CBoard& board, AI& levy, CUciEngine& engine, const t_game& game,
+        const std::string& startFen, CReferee& referee, std::default_random_engine& generator)
+{
+    std::uniform_real_distribution<double> distribution(0.0,1.0);
+
+    std::string position = startFen.empty() ? "startpos" : "fen " + startFen;
+    position += " moves";
+
+    std::ostringstream log;
+    if (gMatchLog)
+    {
+        log << "Init value:\n" << board.getValue() << '\n';
+        std::cerr << log.str();
+    }
+
+    levy.newGame();
+    referee.newGame(board);
+    while (!referee.beforeMove(board))
+    {
+        referee.startClock();
+        CMove best_move;
+        if (game.isPlayingWhite == board.whiteToMove())
+        {
+            levy.setLimits(referee.limits());
+            best_move = levy.find_best_or_worst_move(distribution(generator) <= game.strength);
+        }
+        else
+        {
+            std::string answer;
+            if (!engine.go(position, referee.limits(), answer) ||
+                    best_move.FromString(answer.c_str()) == NULL ||
+                    !board.IsMoveValid(best_move))
+            {
+                log.str("");
+                log << "Engine failed, answer '" << answer << "'\n";
+                if (gMatchLog) std::cerr << log.str();
+                referee.forfeit(board, "engine failure");
+                engine.stop();
+                break;
+            }
+        }
+        board.make_move(best_move);
+        position += " " + best_move.ToShortString();
+
+        int value = board.getValue();
+        log.str("");
+        log << best_move.ToLongString() << ' ' << value << '\n';
+        if (gMatchLog) std::cerr << log.str();
+
+        if (referee.afterMove(board, best_move, value))
+            break;
+    }
+
+    return logResult(game, referee, levy);
+} // end of match
+
+
+/***************************************************************
+ * constructor
+ ***************************************************************/
+CMatchRunner::CMatchRunner(int players, unsigned int threads, unsigned int hashMb)
+    : m_players(players), m_threads(threads), m_hashMb(hashMb), m_lazyMargin(0), m_seed(DEFAULT_SEED),
+    m_limits(), m_adj(), m_openings(NULL), m_engine(), m_useSprt(false), m_sprt(), m_games(), m_nextGame(0),
+    m_results(2*players*3), m_mutex(), m_decisions(2*players, CSprt::sprtContinue)
+{
+    if (m_threads == 0)
+        m_threads = pl::ThreadPool::instance().size();
+
+    for (unsigned int i=0; i<m_results.size(); ++i)
+    {
+        m_results[i] = 0;
+    }
+} // end of constructor
+
+
+/***************************************************************
+ * run
+ * Plays all the games, and returns when they are finished.
+ ***************************************************************/
+void CMatchRunner::run()
+{
+    m_nextGame = 0;
+
+    // One long-running task per worker, on the shared pool.
+    pl::parallel_for(0, m_threads, [this](unsigned int id) { worker(id); });
+} // end of run
+
+
+/***************************************************************
+ * worker
+ ***************************************************************/
+void CMatchRunner::worker(unsigned int)
+{
+    std::default_random_engine generator;
+
+    CBoard board;
+    AI levy(board, m_seed, m_hashMb);
+    AI gm(board, m_seed, m_hashMb);
+    if (m_lazyMargin > 0)
+    {
+        levy.setLazyEval(true, m_lazyMargin);
+        gm.setLazyEval(true, m_lazyMargin);
+    }
+
+    CReferee referee(m_adj, m_limits);
+    CUciEngine engine;
+    bool useEngine = !m_engine.empty();
+
+    while (true)
+    {
+        unsigned int i = m_nextGame++;
+        if (i >= m_games.size())
+            break;
+
+        const t_game& game = m_games[i];
+        if (decided(game))
+            continue;
+
+        std::ostringstream log;
+        log << "Against " << (game.againstStockFish ? "StockFish " : "StinkFish ")
+            << game.player << " (game " << i << ")\n";
+        if (gMatchLog) std::cerr << log.str();
+
+        // Every game gets its own seeds, so it does not depend on the worker.
+        generator.seed(m_seed + 3*i);
+        levy.setSeed(m_seed + 3*i + 1);
+        gm.setSeed(m_seed + 3*i + 2);
+
+        std::string startFen;
+        if (m_openings && game.opening >= 0)
+        {
+            startFen = m_openings->fen(game.opening);
+            if (m_openings->setup(board, game.opening))
+            {
+                std::cerr << "Bad opening, game not played: " << startFen << std::endl;
+                continue;
+            }
+        }
+        else
+        {
+            board.newGame();
+        }
+
+        e_result result;
+        if (game.againstStockFish && useEngine)
+        {
+            // An engine that failed, or does not get ready, is started
+            // again, so it does not lose all its later games too.
+            if (!(engine.running() && engine.newGame()) && !engine.start(m_engine))
+            {
+                std::cerr << "Could not start engine, game not played: " << m_engine << std::endl;
+                continue;
+            }
+            result = match(board, levy, engine, game, startFen, referee, generator);
+        }
+        else
+        {
+            result = match(board, levy, gm, game, referee, generator);
+        }
+        m_results[index(game.againstStockFish, game.player, result)]++;
+        updateSprt(game);
+    }
+} // end of worker
+
+
+/***************************************************************
+ * decided
+ * Returns true, if the SPRT has decided the pairing of this game.
+ ***************************************************************/
+bool CMatchRunner::decided(const t_game& game)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_decisions[index(game.againstStockFish, game.player, resultLoss)/3] != CSprt::sprtContinue;
+} // end of decided
+
+
+/***************************************************************
+ * updateSprt
+ * Runs the SPRT on the results of the pairing of this game.
+ * Games that finish after the decision are still counted.
+ ***************************************************************/
+void CMatchRunner::updateSprt(const t_game& game)
+{
+    if (!m_useSprt)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    CSprt::e_status& status = m_decisions[index(game.againstStockFish, game.player, resultLoss)/3];
+    if (status != CSprt::sprtContinue)
+        return;
+
+    int losses = result(game.againstStockFish, game.player, resultLoss);
+    int draws  = result(game.againstStockFish, game.player, resultDraw);
+    int wins   = result(game.againstStockFish, game.player, resultWin);
+    status = m_sprt.status(losses, draws, wins);
+
+    if (status != CSprt::sprtContinue)
+    {
+        std::ostringstream log;
+        log << "SPRT: " << (game.againstStockFish ? "StockFish " : "StinkFish ")
+            << game.player << " accepts " << (status == CSprt::sprtH1 ? "H1" : "H0")
+            << " after " << losses + draws + wins << " games (llr "
+            << m_sprt.llr(losses, draws, wins) << ")\n";
+        std::cerr << log.str();
+    }
+} // end of updateSprt
+
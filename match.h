@@ -0,0 +1,133 @@
+#ifndef _MATCH_H_
+#define _MATCH_H_
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CBoard.h"
+#include "ai.h"
+#include "CSearchLimits.h"
+#include "CSprt.h"
+#include "COpenings.h"
+#include "CReferee.h"
+#include "CUciEngine.h"
+
+// Result of a game, seen from the player.
+typedef enum
+{
+    resultLoss = 0,
+    resultDraw,
+    resultWin
+} e_result;
+
+// Description of one game in the experiment.
+typedef struct
+{
+    int    player;           // Index of the strength level
+    double strength;         // Probability of the player choosing the best move
+    bool   isPlayingWhite;
+    bool   againstStockFish; // Opponent plays the best (true) or worst (false) moves,
+                             // or is the external engine (true), if there is one
+    int    opening;          // Index in the opening suite, or -1 for the start position
+} t_game;
+
+// One position of a game, for training data (see CSelfPlay).
+struct t_trainingRecord
+{
+    CPackedBoard position;
+    int16_t      score;    // Search score, for the side to move
+    int8_t       result;   // 1 = win, 0 = draw, -1 = loss, for the side to move
+    uint8_t      reserved;
+};
+
+// If records is given, the position before each move is added,
+// with the score of the search that found the move.
+e_result match(CBoard& board, AI& levy, AI& gm, const t_game& game,
+        CReferee& referee, std::default_random_engine& generator,
+        std::vector<t_trainingRecord> *records = NULL);
+
+// The same, but the opponent is an external UCI engine. The start
+// position is startFen, or the initial position, if it is empty.
+e_result match(CBoard& board, AI& levy, CUciEngine& engine, const t_game& game,
+        const std::string& startFen, CReferee& referee, std::default_random_engine& generator);
+
+// Enables (default) or disables the log of every game to std::cerr.
+void setMatchLog(bool enable);
+
+
+/***************************************************************
+ * declaration of CMatchRunner
+ *
+ * This plays a list of independent games on a fixed number of
+ * worker threads. Each worker owns a board and a pair of engines,
+ * and takes the next game from the list, until all are played.
+ * The games start from the start position, or from a position in
+ * the opening suite.
+ * The results are counted atomically.
+ *
+ * With an external engine, the games against StockFish are played
+ * against that engine. Each worker starts its own copy.
+ *
+ * With an SPRT, the games of a pairing (player and opponent) are
+ * skipped, once the test has decided the result of that pairing.
+ ***************************************************************/
+class CMatchRunner
+{
+    public:
+        enum {DEFAULT_SEED = 2022};
+
+        CMatchRunner(int players, unsigned int threads, unsigned int hashMb);
+
+        void add(const t_game& game) {m_games.push_back(game);}
+        void setLazyEval(int margin) {m_lazyMargin = margin;}
+        void setLimits(const CSearchLimits& limits) {m_limits = limits;}
+        void setSprt(const CSprt& sprt) {m_sprt = sprt; m_useSprt = true;}
+        void setAdjudication(const t_adjudication& adj) {m_adj = adj;}
+        void setOpenings(const COpenings *openings) {m_openings = openings;}
+        void setEngine(const std::string& command) {m_engine = command;}
+
+        // The random numbers of game i are seeded from seed + i, so a
+        // game with a node or depth limit is the same on every run,
+        // whichever worker plays it.
+        void setSeed(unsigned int seed) {m_seed = seed;}
+        void run();
+
+        int result(bool againstStockFish, int player, e_result result) const
+            {return m_results[index(againstStockFish, player, result)];}
+
+        CSprt::e_status decision(bool againstStockFish, int player) const
+            {return m_decisions[index(againstStockFish, player, resultLoss)/3];}
+
+    private:
+        CMatchRunner(const CMatchRunner&) = delete;
+        CMatchRunner& operator=(const CMatchRunner&) = delete;
+
+        void worker(unsigned int id);
+        bool decided(const t_game& game);
+        void updateSprt(const t_game& game);
+        unsigned int index(bool againstStockFish, int player, e_result result) const
+            {return ((againstStockFish ? m_players : 0) + player)*3 + result;}
+
+        int                            m_players;
+        unsigned int                   m_threads;
+        unsigned int                   m_hashMb;
+        int                            m_lazyMargin;
+        unsigned int                   m_seed;
+        CSearchLimits                  m_limits;
+        t_adjudication                 m_adj;
+        const COpenings               *m_openings;  // Shared by all workers
+        std::string                    m_engine;    // Command of the external engine
+        bool                           m_useSprt;
+        CSprt                          m_sprt;
+        std::vector<t_game>            m_games;
+        std::atomic<unsigned int>      m_nextGame;
+        std::vector<std::atomic<int> > m_results;
+        std::mutex                     m_mutex;     // Protects m_decisions
+        std::vector<CSprt::e_status>   m_decisions; // One per pairing
+}; // end of CMatchRunner
+
+#endif // _MATCH_H_
+
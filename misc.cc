@@ -78,6 +78,88 @@ void unmap_file(const void *data, map_t map)
 #endif
 }
 
+// Huge pages are 2 MB on x86-64. Large tables are rounded up to them.
+#define HUGE_PAGE_SIZE (2*1024*1024)
+
+static size_t large_size(size_t size)
+{
+  return (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+}
+
+#ifndef _WIN32
+// madvise() also succeeds when transparent huge pages are turned
+// off, so the setting of the kernel is read to know if they are used.
+static bool thp_enabled(void)
+{
+  char buf[64] = "";
+  FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (!f)
+    return false;
+  if (!fgets(buf, sizeof(buf), f))
+    buf[0] = 0;
+  fclose(f);
+  return buf[0] && !strstr(buf, "[never]");
+}
+#endif
+
+void *alloc_large(size_t size, const char **mode)
+{
+  size = large_size(size);
+
+#ifndef _WIN32
+
+  void *data;
+
+#ifdef MAP_HUGETLB
+  // Explicit huge pages. Only if the administrator has reserved them.
+  data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (data != MAP_FAILED) {
+    *mode = "huge pages (hugetlb)";
+    return data;
+  }
+#endif
+
+  // Transparent huge pages need a mapping aligned to the huge page
+  // size, so one more huge page is mapped, and the ends cut off.
+  char *raw = (char *)mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED)
+    return NULL;
+
+  char *aligned = (char *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+  if (aligned > raw)
+    munmap(raw, aligned - raw);
+  if (raw + HUGE_PAGE_SIZE > aligned)
+    munmap(aligned + size, raw + HUGE_PAGE_SIZE - aligned);
+
+  *mode = "normal pages";
+#ifdef MADV_HUGEPAGE
+  if (madvise(aligned, size, MADV_HUGEPAGE) == 0 && thp_enabled())
+    *mode = "huge pages (madvise)";
+#endif
+  return aligned;
+
+#else
+
+  *mode = "normal pages";
+  return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+#endif
+}
+
+void free_large(void *data, size_t size)
+{
+  if (!data) return;
+
+#ifndef _WIN32
+  munmap(data, large_size(size));
+#else
+  (void)size;
+  VirtualFree(data, 0, MEM_RELEASE);
+#endif
+}
+
 /*
 FEN
 */
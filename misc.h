@@ -37,6 +37,12 @@ size_t file_size(FD fd);
 const void *map_file(FD fd, map_t *map);
 void unmap_file(const void *data, map_t map);
 
+// Zeroed memory for a large table, that is read at random. Huge
+// pages are used if possible, as they save most of the TLB misses.
+// *mode tells which kind of pages is used. Returns NULL on error.
+void *alloc_large(size_t size, const char **mode);
+void free_large(void *data, size_t size);
+
 INLINE uint32_t readu_le_u32(const void *p)
 {
   const uint8_t *q = (const uint8_t*) p;
@@ -49,6 +55,20 @@ INLINE uint16_t readu_le_u16(const void *p)
   return q[0] | (q[1] << 8);
 }
 
+#if defined(_MSC_VER)
+INLINE unsigned bsf(uint64_t b)
+{
+  unsigned long idx;
+  _BitScanForward64(&idx, b);
+  return idx;
+}
+#else
+INLINE unsigned bsf(uint64_t b)
+{
+  return __builtin_ctzll(b);
+}
+#endif
+
 void decode_fen(const char* fen_str, int* player, int* castle,
        int* fifty, int* move_number, int* piece, int* square);
 
@@ -886,7 +886,10 @@ INLINE void affine_txfm(clipped_t *input, void *output, unsigned inDims,
 
 // Input feature converter
 static int16_t ft_biases alignas(64) [kHalfDimensions];
-static int16_t ft_weights alignas(64) [kHalfDimensions * FtInDims];
+// The weights are read at random, one column per active feature.
+// They are allocated in nnue_init(), on huge pages if possible.
+static int16_t *ft_weights;
+static const char *ft_weights_mode = "";
 
 #ifdef VECTOR
 #define TILE_HEIGHT (NUM_REGS * SIMD_WIDTH / 16)
@@ -1090,6 +1093,7 @@ int nnue_evaluate_pos(Position *pos)
 #define B(x) (buf.x)
 #endif
 
+  assert(ft_weights && "nnue_init() must be called before an evaluation");
   transform(pos, B(input), input_mask);
 
   affine_txfm(B(input), B(hidden1_out), FtOutDims, 32,
@@ -1266,19 +1270,26 @@ static bool load_eval_file(const char *evalFile)
 /*
 Interfaces
 */
-void nnue_init(const char* evalFile)
+bool nnue_init(const char* evalFile)
 {
-  printf("Loading NNUE : %s\n", evalFile);
-  fflush(stdout);
+  fprintf(stderr, "Loading NNUE : %s\n", evalFile);
+
+  if (!ft_weights) {
+    ft_weights = (int16_t *)alloc_large(sizeof(int16_t) * kHalfDimensions * FtInDims, &ft_weights_mode);
+    if (!ft_weights) {
+      fprintf(stderr, "Out of memory for the NNUE weights!\n");
+      exit(1);
+    }
+    fprintf(stderr, "NNUE weights on %s\n", ft_weights_mode);
+  }
 
   if (load_eval_file(evalFile)) {
-    printf("NNUE loaded !\n");
-    fflush(stdout);
-    return;
+    fprintf(stderr, "NNUE loaded !\n");
+    return true;
   }
 
-  printf("NNUE file not found!\n");
-  fflush(stdout);
+  fprintf(stderr, "NNUE file not found!\n");
+  return false;
 }
 
 int nnue_evaluate(
@@ -1313,6 +1324,27 @@ int nnue_evaluate_incremental(
   return nnue_evaluate_pos(&pos);
 }
 
+const char* nnue_arch(void)
+{
+#if defined(USE_AVX512)
+  return "avx512";
+#elif defined(USE_AVX2)
+  return "avx2";
+#elif defined(USE_SSE41)
+  return "sse41";
+#elif defined(USE_SSSE3)
+  return "ssse3";
+#elif defined(USE_SSE2)
+  return "sse2";
+#elif defined(USE_MMX)
+  return "mmx";
+#elif defined(USE_NEON)
+  return "neon";
+#else
+  return "generic";
+#endif
+}
+
 int nnue_evaluate_fen(const char* fen)
 {
   int pieces[33],squares[33],player,castle,fifty,move_number;
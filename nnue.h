@@ -96,9 +96,10 @@ int nnue_evaluate_pos(Position* pos);
 **************************************************************************/
 
 /**
-* Load NNUE file
+* Load NNUE file. Progress is reported on stderr.
+* Returns true if the file was loaded.
 */
-void nnue_init(
+bool nnue_init(
   const char * evalFile             /** Path to NNUE file */
 );
 
@@ -152,4 +153,10 @@ int nnue_evaluate_incremental(
   NNUEdata** nnue_data              /** Pointer to NNUEdata* for current and previous plies */
 );
 
+/**
+* Name of the SIMD code path this library was compiled for,
+* e.g. "avx2" or "generic".
+*/
+const char* nnue_arch(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <string.h>
+#include <vector>
+
+#include "pack.h"
+#include "parallel_for.h"
+
+enum
+{
+    BLOCK_SIZE  = 4096,    // Records unpacked at a time
+    WINDOW_SIZE = 64 << 20 // Bytes of EPD packed at a time
+};
+
+/***************************************************************
+ * pack_positions
+ ***************************************************************/
+unsigned long pack_positions(const CLineFile& file, std::ostream& os)
+{
+    pl::ThreadPool& pool = pl::ThreadPool::instance();
+    unsigned int parts = 4 * pool.size();
+
+    unsigned long count = 0;
+    CLineFile::t_range rest = file.all();
+    while (rest.begin < rest.end)
+    {
+        CLineFile::t_range window = CLineFile::head(rest, WINDOW_SIZE);
+        rest.begin = window.end;
+
+        std::vector<CLineFile::t_range> ranges = CLineFile::split(window, parts);
+        std::vector<std::vector<CPackedBoard> > blocks(ranges.size());
+
+        pl::parallel_for(0, ranges.size(), [&](unsigned int i)
+        {
+            CBoard board;
+            std::vector<CPackedBoard>& block = blocks[i];
+            CLineFile::forEachLine(ranges[i], [&](const char *line, size_t length)
+            {
+                if (length == 0 || line[0] == '#')
+                    return;
+
+                std::string fen(line, length);
+                if (board.read_from_fen(fen.c_str()))
+                {
+                    std::cerr << "Error reading FEN: " + fen + "\n";
+                    return;
+                }
+
+                block.push_back(CPackedBoard());
+                board.pack(block.back());
+            });
+        });
+
+        for (unsigned int i = 0; i < blocks.size(); ++i)
+        {
+            if (blocks[i].empty())
+                continue;
+            os.write((const char *) &blocks[i][0], blocks[i].size()*sizeof(CPackedBoard));
+            count += blocks[i].size();
+        }
+    }
+    os.flush();
+
+    return count;
+} // end of pack_positions
+
+
+/***************************************************************
+ * unpack_positions
+ ***************************************************************/
+unsigned long unpack_positions(std::istream& is, std::ostream& os, unsigned int recordSize)
+{
+    if (recordSize < sizeof(CPackedBoard))
+        return 0;
+
+    CBoard board;
+    std::vector<char> block(BLOCK_SIZE*recordSize);
+    std::string text;
+
+    unsigned long count = 0;
+    while (is)
+    {
+        is.read(&block[0], block.size());
+        unsigned int records = is.gcount() / recordSize;
+
+        text.clear();
+        for (unsigned int i = 0; i < records; ++i)
+        {
+            CPackedBoard packed;
+            memcpy(&packed, &block[i*recordSize], sizeof(packed));
+            if (board.unpack(packed))
+            {
+                std::cerr << "Record " << count + i << ": invalid position" << std::endl;
+                continue;
+            }
+            text += board.toFen();
+            text += '\n';
+        }
+        os << text;
+        count += records;
+    }
+    os.flush();
+
+    return count;
+} // end of unpack_positions
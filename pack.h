@@ -0,0 +1,25 @@
+#ifndef _PACK_H_
+#define _PACK_H_
+
+#include <iostream>
+
+#include "CBoard.h"
+#include "CLineFile.h"
+
+// Converts every position of an EPD or FEN file to a CPackedBoard,
+// and writes them to os in the same order. EPD operations are not
+// kept. Lines that are not a valid position are reported on
+// std::cerr and skipped. The file is converted a window at a time,
+// on all threads of the shared pool.
+// Returns the number of positions written.
+unsigned long pack_positions(const CLineFile& file, std::ostream& os);
+
+// The reverse: reads CPackedBoard records from is, and writes one
+// FEN line per record to os. The records may be part of a larger
+// record of recordSize bytes, e.g. the training data of CSelfPlay,
+// in which case the rest of the record is skipped.
+// Returns the number of records read.
+unsigned long unpack_positions(std::istream& is, std::ostream& os,
+        unsigned int recordSize = sizeof(CPackedBoard));
+
+#endif // _PACK_H_
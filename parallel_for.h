@@ -1,88 +1,247 @@
+#ifndef _PARALLEL_FOR_H_
+#define _PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <vector>
+#include <deque>
 #include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace pl{
 
-    void thread_par_for(unsigned start, unsigned end, std::function<void(unsigned i)> fn, bool par = true){
+    /***************************************************************
+     * ThreadPool
+     *
+     * A long-lived pool of worker threads. Each worker has its own
+     * queue of tasks. A worker takes tasks from the back of its own
+     * queue, and when that is empty, it steals from the front of the
+     * other queues. Tasks submitted from a worker go to the queue of
+     * that worker; other tasks are spread over the queues in turn.
+     ***************************************************************/
+    class ThreadPool{
+        public:
+            explicit ThreadPool(unsigned nb_threads = 0) :
+                m_queues(), m_threads(), m_mutex(), m_cond(),
+                m_pending(0), m_next_queue(0), m_stop(false)
+            {
+                start(nb_threads);
+            }
 
-        //internal loop
-        auto int_fn = [&fn](unsigned int_start, unsigned seg_size){
-            for (unsigned j = int_start; j < int_start+seg_size; j++){
-                fn(j);
+            ~ThreadPool(){
+                stop();
             }
-        };
 
-        //sequenced for
-        if(!par){
-            return int_fn(start, end);
-        }
+            //the pool shared by the whole program
+            static ThreadPool& instance(){
+                static ThreadPool pool;
+                return pool;
+            }
 
-        //get number of threads
-        unsigned nb_threads_hint = std::thread::hardware_concurrency();
-        unsigned nb_threads = nb_threads_hint == 0 ? 8 : (nb_threads_hint);
-
-        //calculate segments
-        unsigned total_length = end - start;
-        unsigned seg = total_length/nb_threads;
-        unsigned last_seg = seg + total_length%nb_threads;
-
-        //launch threads - parallel for
-        auto threads_vec = std::vector<std::thread>();
-        threads_vec.reserve(nb_threads);
-        for(unsigned k = 0; k < nb_threads-1; ++k){
-            unsigned current_start = seg*k;
-            threads_vec.emplace_back(std::thread(int_fn, current_start, seg));
-        }
-        {
-            unsigned current_start = seg*(nb_threads-1);
-            threads_vec.emplace_back(std::thread(int_fn, current_start, last_seg));
-        }
-        for (auto& th : threads_vec){
-            th.join();
-        }
-    }
+            unsigned size() const {return m_threads.size();}
 
+            //change the number of threads. Must only be called when the pool is idle.
+            void resize(unsigned nb_threads){
+                if (nb_threads == 0)
+                    nb_threads = default_size();
+                if (nb_threads == size())
+                    return;
+                stop();
+                start(nb_threads);
+            }
+
+            //queue a task, and return a future for its result
+            template<class Fn>
+            auto submit(Fn fn) -> std::future<decltype(fn())>{
+                typedef decltype(fn()) result_t;
+                auto task = std::make_shared<std::packaged_task<result_t()> >(fn);
+                std::future<result_t> fut = task->get_future();
+                push([task](){ (*task)(); });
+                return fut;
+            }
+
+            //run one queued task on the calling thread. Returns false if there was none.
+            bool run_one(){
+                std::function<void()> task;
+                if (!pop(current_queue(), task))
+                    return false;
+                task();
+                return true;
+            }
 
+        private:
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
 
+            struct queue_t{
+                queue_t() : mutex(), tasks() {}
+                std::mutex mutex;
+                std::deque<std::function<void()> > tasks;
+            };
 
-    void async_par_for(unsigned start, unsigned end, std::function<void(unsigned i)> fn, bool par = true){
+            static unsigned default_size(){
+                unsigned nb_threads_hint = std::thread::hardware_concurrency();
+                return nb_threads_hint == 0 ? 8 : nb_threads_hint;
+            }
+
+            //pool and queue index of the calling thread, if it is a worker
+            static const ThreadPool*& current_pool(){
+                static thread_local const ThreadPool* pool = NULL;
+                return pool;
+            }
+
+            static int& current_queue_ref(){
+                static thread_local int index = -1;
+                return index;
+            }
+
+            //index of the queue of the calling worker, or -1 if not a worker of this pool
+            int current_queue() const{
+                return current_pool() == this ? current_queue_ref() : -1;
+            }
+
+            void start(unsigned nb_threads){
+                if (nb_threads == 0)
+                    nb_threads = default_size();
+                m_stop = false;
+                m_queues.clear();
+                for (unsigned k = 0; k < nb_threads; ++k)
+                    m_queues.push_back(std::unique_ptr<queue_t>(new queue_t));
+                for (unsigned k = 0; k < nb_threads; ++k)
+                    m_threads.emplace_back(&ThreadPool::worker, this, k);
+            }
+
+            void stop(){
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+                m_cond.notify_all();
+                for (auto& th : m_threads)
+                    th.join();
+                m_threads.clear();
+            }
+
+            void push(std::function<void()> task){
+                int own = current_queue();
+                unsigned k = own >= 0 ? own : m_next_queue++ % m_queues.size();
+                {
+                    std::unique_lock<std::mutex> lock(m_queues[k]->mutex);
+                    m_queues[k]->tasks.push_back(std::move(task));
+                }
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_pending++;
+                }
+                m_cond.notify_one();
+            }
+
+            //take a task from our own queue (newest first), or steal one (oldest first)
+            bool pop(int own, std::function<void()>& task){
+                unsigned nb = m_queues.size();
+                for (unsigned i = 0; i < nb; ++i){
+                    unsigned k = own >= 0 ? (own + i) % nb : i;
+                    std::unique_lock<std::mutex> lock(m_queues[k]->mutex);
+                    std::deque<std::function<void()> >& tasks = m_queues[k]->tasks;
+                    if (tasks.empty())
+                        continue;
+                    if (i == 0 && own >= 0){
+                        task = std::move(tasks.back());
+                        tasks.pop_back();
+                    }
+                    else{
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+                    lock.unlock();
+                    std::unique_lock<std::mutex> lock2(m_mutex);
+                    m_pending--;
+                    return true;
+                }
+                return false;
+            }
+
+            void worker(unsigned k){
+                current_pool() = this;
+                current_queue_ref() = k;
+                while (true){
+                    std::function<void()> task;
+                    if (pop(k, task)){
+                        task();
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cond.wait(lock, [this](){ return m_stop || m_pending > 0; });
+                    if (m_stop && m_pending == 0)
+                        return;
+                }
+            }
+
+            std::vector<std::unique_ptr<queue_t> > m_queues;
+            std::vector<std::thread>  m_threads;
+            std::mutex                m_mutex;    //protects m_pending and m_stop
+            std::condition_variable   m_cond;
+            unsigned                  m_pending;  //number of queued tasks
+            std::atomic<unsigned>     m_next_queue;
+            bool                      m_stop;
+    };
+
+
+    /***************************************************************
+     * parallel_for
+     *
+     * Calls fn(i) for every i in [start, end[ using the pool.
+     * The indices are handed out one grain at a time, so threads that
+     * finish early take more work. The calling thread takes part in
+     * the loop, and runs other queued tasks while it waits, so it is
+     * safe to call parallel_for from inside a task.
+     ***************************************************************/
+    template<class Fn>
+    void parallel_for(unsigned start, unsigned end, Fn fn, unsigned grain = 1,
+            ThreadPool& pool = ThreadPool::instance()){
+
+        if (end <= start)
+            return;
+        if (grain == 0)
+            grain = 1;
+
+        std::atomic<unsigned> next(start);
 
         //internal loop
-        auto int_fn = [&fn](unsigned int_start, unsigned seg_size){
-            for (unsigned j = int_start; j < int_start+seg_size; j++){
-                fn(j);
+        auto int_fn = [&next, &fn, end, grain](){
+            while (true){
+                unsigned j = next.fetch_add(grain);
+                if (j >= end)
+                    return;
+                unsigned j_end = end - j < grain ? end : j + grain;
+                for (; j < j_end; ++j)
+                    fn(j);
             }
         };
 
-        //sequenced for
-        if(!par){
-            return int_fn(start, end);
-        }
+        //launch helpers, one per thread in the pool, but no more than needed
+        unsigned nb_chunks = (end - start + grain - 1) / grain;
+        unsigned nb_helpers = std::min(pool.size(), nb_chunks - 1);
+        std::vector<std::future<void> > fut_vec;
+        fut_vec.reserve(nb_helpers);
+        for (unsigned k = 0; k < nb_helpers; ++k)
+            fut_vec.push_back(pool.submit(int_fn));
 
-        //get number of threads
-        unsigned nb_threads_hint = std::thread::hardware_concurrency();
-        unsigned nb_threads = nb_threads_hint == 0 ? 8 : (nb_threads_hint);
-
-        //calculate segments
-        unsigned total_length = end - start;
-        unsigned seg = total_length/nb_threads;
-        unsigned last_seg = seg + total_length%nb_threads;
-
-        //launch threads - parallel for
-        auto fut_vec = std::vector<std::future<void>>();
-        fut_vec.reserve(nb_threads);
-        for(unsigned k = 0; k < nb_threads-1; ++k){
-            unsigned current_start = seg*k;
-            fut_vec.emplace_back(std::async(int_fn, current_start, seg));
-        }
-        {
-            unsigned current_start = seg*(nb_threads-1);
-            fut_vec.emplace_back(std::async(std::launch::async, int_fn, current_start, last_seg));
-        }
-        for (auto& th : fut_vec){
-            th.get();
+        int_fn();
+
+        for (auto& fut : fut_vec){
+            while (fut.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+                if (!pool.run_one())
+                    std::this_thread::yield();
+            }
+            fut.get();
         }
     }
-}
\ No newline at end of file
+}
+
+#endif // _PARALLEL_FOR_H_
@@ -0,0 +1,98 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "perft.h"
+#include "CMoveList.h"
+#include "parallel_for.h"
+
+/***************************************************************
+ * perft
+ ***************************************************************/
+unsigned long perft(CBoard& board, int depth)
+{
+    if (depth == 0)
+        return 1;
+
+    CMoveList moves;
+    board.find_legal_moves(moves);
+
+    unsigned long nodes = 0;
+    for (unsigned int i=0; i<moves.size(); ++i)
+    {
+        board.make_move(moves[i]);
+        // find_legal_moves may return moves that leave the king in check.
+        if (!board.isOtherKingInCheck())
+            nodes += perft(board, depth-1);
+        board.undo_move(moves[i]);
+    }
+    return nodes;
+} // end of perft
+
+
+/***************************************************************
+ * perft_suite
+ * Each position is a separate task, so that the few deep
+ * positions don't hold up the rest of the suite.
+ ***************************************************************/
+bool perft_suite(const CLineFile& file, std::ostream& os, int maxDepth)
+{
+    std::vector<std::string> lines;
+    CLineFile::forEachLine(file.all(), [&lines](const char *line, size_t length)
+    {
+        if (length && line[0] != '#')
+            lines.push_back(std::string(line, length));
+    });
+
+    std::vector<std::string> results(lines.size());
+    std::vector<char> passed(lines.size(), 1);
+
+    pl::parallel_for(0, lines.size(), [&](unsigned int i)
+    {
+        std::string::size_type pos = lines[i].find(';');
+        std::string fen = lines[i].substr(0, pos);
+        while (!fen.empty() && isspace((unsigned char) fen[fen.size()-1]))
+            fen.erase(fen.size()-1);
+
+        std::ostringstream out;
+        CBoard board;
+        if (board.read_from_fen(fen.c_str()))
+        {
+            out << "Error reading FEN: " << fen << '\n';
+            passed[i] = 0;
+            results[i] = out.str();
+            return;
+        }
+
+        std::istringstream ss(pos == std::string::npos ? "" : lines[i].substr(pos));
+        std::string tag;
+        unsigned long expected;
+        while (ss >> tag >> expected)
+        {
+            int depth = atoi(tag.c_str() + 2); // Skip ";D"
+            if (maxDepth > 0 && depth > maxDepth)
+                break;
+
+            unsigned long nodes = perft(board, depth);
+            out << fen << " D" << depth << ' ' << nodes;
+            if (nodes != expected)
+            {
+                out << " FAILED, expected " << expected;
+                passed[i] = 0;
+            }
+            out << '\n';
+        }
+        results[i] = out.str();
+    });
+
+    unsigned int failures = 0;
+    for (unsigned int i=0; i<results.size(); ++i)
+    {
+        os << results[i];
+        failures += !passed[i];
+    }
+    os << failures << " of " << results.size() << " positions failed" << std::endl;
+
+    return failures == 0;
+} // end of perft_suite
+
@@ -0,0 +1,19 @@
+#ifndef _PERFT_H_
+#define _PERFT_H_
+
+#include <iostream>
+
+#include "CBoard.h"
+#include "CLineFile.h"
+
+// Counts the leaf nodes of the legal move tree to the given depth.
+unsigned long perft(CBoard& board, int depth);
+
+// Runs perft on every position of a suite in EPD format
+//     <fen> ;D1 <count> ;D2 <count> ...
+// using the shared thread pool. Depths above maxDepth are skipped
+// (0 means no limit). Returns true if all counts matched.
+bool perft_suite(const CLineFile& file, std::ostream& os, int maxDepth);
+
+#endif // _PERFT_H_
+